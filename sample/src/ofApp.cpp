@@ -17,7 +17,7 @@ void ofApp::setup(){
 	// osvr
 	{
 		osvr = OpenSourceVirtualReality::create(osvr_identifier);
-		osvr->addInterface(osvr_interface_head);
+		osvr_head = osvr->addInterface(osvr_interface_head);
 	}
 
 	// allocate fbo
@@ -29,6 +29,7 @@ void ofApp::setup(){
 		s.colorFormats = { GL_RGBA8 };
         
         fbo.allocate(s);
+		osvr_target = osvr->addRenderTarget(FBO_WIDTH, FBO_HEIGHT);
     }
     
 	// setup gui
@@ -57,12 +58,11 @@ void ofApp::setup(){
 void ofApp::update(){
 	ofSetWindowTitle("ofxOSVR sample: " + ofToString(ofGetFrameRate(), 1));
 
-	ofVec3f translation;
-	ofQuaternion rotation;
-	osvr->getInterfacePose(osvr_interface_head, translation, rotation);
+	// head pose and eye matrices from the same tick
+	auto frame = osvr->captureFrame();
 	ofMatrix4x4 model_matrix;
-	model_matrix.setTranslation(translation);
-	model_matrix.setRotate(rotation);
+	if (frame && osvr_head < frame->model_matrices.size())
+		model_matrix = frame->model_matrices[osvr_head];
 
 	
 	
@@ -76,59 +76,25 @@ void ofApp::update(){
 		auto viewport = ofGetCurrentViewport();
 		ofClear(0);
 
-		auto viewers = osvr->getViewers();
-		
-		for (auto& vi : viewers)
+		// one camera per surface, matrices and pixel viewports precomputed
+		if (frame)
+			OSVRCamera::update(frame->viewers, osvr_target, osvr_cameras);
+		for (auto& camera : osvr_cameras)
 		{
-			for (auto& eye : vi.second.eyes)
+			camera.begin();
+
+			// draw something
+			int num_box = 20;
+			float da = TWO_PI / num_box;
+			float r = 1.0f * g_threshold;
+			for (int i = 0; i < num_box; i++)
 			{
-				auto& this_eye = eye.second;
-				for (auto& sf : this_eye.surfaces)
-				{
-					auto& this_surface = sf.second;
-					
-					ofPushView();
-					ofViewport(this_surface.viewport);
-					
-					ofSetMatrixMode(ofMatrixMode::OF_MATRIX_PROJECTION);
-					ofPushMatrix(); // projection matrix
-
-					ofMatrix4x4 proj;
-					ofLoadIdentityMatrix();
-					ofScale(1.0f, -1.0f, 1.0f);
-					ofMultMatrix(this_surface.projection_matrix);
-					
-					{
-						ofSetMatrixMode(ofMatrixMode::OF_MATRIX_MODELVIEW);
-						ofPushMatrix(); // modelview matrix
-						ofLoadMatrix(this_eye.modelview_matrix);
-
-						//auto trans = this_eye.modelview_matrix.getInverse().getTranslation();
-						//printf("eye trans %f, %f, %f\n", trans.x, trans.y, trans.z);
-						//printf("viewport: %f, %f, %f, %f\n", this_surface.viewport.x, this_surface.viewport.y, this_surface.viewport.width, this_surface.viewport.height);
-
-						// draw something
-						int num_box = 20;
-						float da = TWO_PI / num_box;
-						float r = 1.0f * g_threshold;
-						for (int i = 0; i < num_box; i++)
-						{
-							float x = cos(da * i) * r;
-							float y = sin(da * i) * r;
-							ofDrawBox(x, 0.0f, y, 0.1f);
-						}
-
-						ofPopMatrix(); // modelview matrix
-					}
-					ofSetMatrixMode(ofMatrixMode::OF_MATRIX_PROJECTION);
-					ofPopMatrix(); // projection matrix
-
-					ofSetMatrixMode(ofMatrixMode::OF_MATRIX_MODELVIEW);
-
-					ofPopView();
-				}
-				
+				float x = cos(da * i) * r;
+				float y = sin(da * i) * r;
+				ofDrawBox(x, 0.0f, y, 0.1f);
 			}
+
+			camera.end();
 		}
 
 
@@ -5,6 +5,7 @@
 #include "Utilities.h"
 
 #include "OSVR.h"
+#include "OSVRCamera.h"
 
 
 class ofApp : public ofBaseApp{
@@ -57,6 +58,9 @@ private:
 	OpenSourceVirtualRealityRef osvr;
 	const string osvr_identifier = "com.osvr.client.openFrameworks";
 	const string osvr_interface_head = "/me/head";
+	OpenSourceVirtualReality::InterfaceHandle osvr_head;
+	OpenSourceVirtualReality::RenderTarget osvr_target;
+	std::vector<OSVRCamera> osvr_cameras;
 };
 
 
@@ -1,95 +1,68 @@
 #pragma once
 
 #include <memory>
-#include <thread>
-#include <mutex>
 #include <string>
-#include <iostream>
-#include <deque>
-#include <map>
 
 #include "ofMain.h"
-#include "osvr/ClientKit/Interface.h"
+#include "OSVRThreadedTracker.h"
+#include "OSVRMultiTracker.h"
 
 using OpenSourceVirtualRealityRef = std::shared_ptr<class OpenSourceVirtualReality>;
 
-class OpenSourceVirtualReality
+// hands out openFrameworks types straight from the core
+struct OfMathPolicy
 {
-public:
-	static OpenSourceVirtualRealityRef create(std::string applicationIdentifier, bool serverAutoStart = true)
-	{
-		return OpenSourceVirtualRealityRef(new OpenSourceVirtualReality(applicationIdentifier, serverAutoStart));
-	}
+	using Vec3 = ofVec3f;
+	using Quat = ofQuaternion;
+	using Matrix = ofMatrix4x4;
+	using Rect = ofRectangle;
+
+	static void setVec3(Vec3& v, double x, double y, double z) { v.set(x, y, z); }
+	static void setQuat(Quat& q, double x, double y, double z, double w) { q.set(x, y, z, w); }
+	static void setRect(Rect& r, double x, double y, double width, double height) { r.set(x, y, width, height); }
+	static float* getPtr(Matrix& m) { return m.getPtr(); }
+	static const float* getPtr(const Matrix& m) { return m.getPtr(); }
+	static void getRect(const Rect& r, float out[4]) { out[0] = r.x; out[1] = r.y; out[2] = r.width; out[3] = r.height; }
+};
 
-	~OpenSourceVirtualReality();
+// several servers behind one handle space with of math types, see OSVRMultiTracker
+using OpenSourceVirtualRealityMultiServer = OSVRMultiTracker<OSVRThreadedTracker<OSVRTrackingCore<MutexLockPolicy, MapStoragePolicy, OfMathPolicy>>>;
 
-	void addInterface(std::string path)
+// openFrameworks front end: of math types, core logging routed to ofLog
+class OpenSourceVirtualReality : public OSVRThreadedTracker<OSVRTrackingCore<MutexLockPolicy, MapStoragePolicy, OfMathPolicy>>
+{
+public:
+	// instances created for the same application identifier share one context and poll
+	// thread, see OSVRTrackerRegistry
+	static OpenSourceVirtualRealityRef create(std::string applicationIdentifier, bool serverAutoStart = true, const OSVRThreadOptions& options = OSVRThreadOptions())
 	{
-		std::lock_guard<std::mutex> guard(mtx);
-		interface_paths.push_back(path);
+		return OSVRTrackerRegistry<OpenSourceVirtualReality>::acquire(applicationIdentifier, [&]
+		{
+			installLogHandler();
+			return OpenSourceVirtualRealityRef(new OpenSourceVirtualReality(applicationIdentifier, serverAutoStart, options));
+		});
 	}
 
-	bool getInterfacePose(const std::string& path, ofVec3f& translation, ofQuaternion& rotation);
-
-	struct Surface
-	{
-		ofMatrix4x4 projection_matrix;
-		ofRectangle viewport;
-	};
-
-	struct Eye
-	{
-		ofMatrix4x4 modelview_matrix;
-		std::map<uint32_t, Surface> surfaces;
-	};
-
-	struct Viewer
-	{
-		std::map<uint32_t, Eye> eyes;
-	};
-
-	std::map<uint32_t, Viewer> getViewers()
+	// servers are added with addServer
+	static std::shared_ptr<OpenSourceVirtualRealityMultiServer> createMultiServer(std::string applicationIdentifier)
 	{
-		std::lock_guard<std::mutex> guard(mtx);
-		return viewers;
+		installLogHandler();
+		return std::make_shared<OpenSourceVirtualRealityMultiServer>(applicationIdentifier);
 	}
 
-protected:
-	struct InterfaceInfo
-	{	
-		InterfaceInfo() {}
-		InterfaceInfo(osvr::clientkit::Interface face)
-			:interface(face)
-		{
-
-		}
-		osvr::clientkit::Interface interface;		
-		OSVR_PoseState state;
-		OSVR_TimeValue timestamp;
-	};
-
 private:
-	OpenSourceVirtualReality(std::string applicationIdentifier, bool serverAutoStart);
-	
-	void threadFunction(bool serverAutoStart);
-
-	static void poseCallback(void *userdata, const OSVR_TimeValue *timestamp, const OSVR_PoseReport *report);
-	static void orientationCallback(void *userdata, const OSVR_TimeValue *timestamp, const OSVR_OrientationReport *report);
-	static void positionCallback(void *userdata, const OSVR_TimeValue *timestamp, const OSVR_PositionReport *report);
-
-	std::thread thd;
-	std::mutex mtx;
-	std::string app_identifier = "";
-	bool is_thread_running = true;
-	int fps = 60;
-	const string module = "OSVR";
+	OpenSourceVirtualReality(std::string applicationIdentifier, bool serverAutoStart, const OSVRThreadOptions& options)
+		:OSVRThreadedTracker(applicationIdentifier, serverAutoStart, options)
+	{
 
-	ofMatrix4x4 modelview_matrix;
-	ofRectangle viewport;
-	ofMatrix4x4 projection_matrix;
+	}
 
-	std::deque<std::string> interface_paths;
-	//std::map<std::string, osvr::clientkit::Interface> interfaces;
-	std::map<std::string, InterfaceInfo> interface_infos;
-	std::map<uint32_t, Viewer> viewers;
+	static void installLogHandler();
 };
+
+// plain float conversions, for code handed PodMathPolicy data
+inline ofVec3f toOf(const OSVRVec3& v) { return ofVec3f(v.x, v.y, v.z); }
+inline ofQuaternion toOf(const OSVRQuat& q) { return ofQuaternion(q.x, q.y, q.z, q.w); }
+inline ofMatrix4x4 toOf(const OSVRMatrix& m) { return ofMatrix4x4(m.m); }
+inline ofRectangle toOf(const OSVRRect& r) { return ofRectangle(r.x, r.y, r.width, r.height); }
+inline ofRectangle toOf(const OSVRViewport& r) { return ofRectangle(r.x, r.y, r.width, r.height); }
@@ -0,0 +1,197 @@
+#include "OSVRCalibration.h"
+
+#include <algorithm>
+
+namespace
+{
+	// q = a * b, w x y z
+	void multiply(const double a[4], const double b[4], double q[4])
+	{
+		q[0] = a[0] * b[0] - a[1] * b[1] - a[2] * b[2] - a[3] * b[3];
+		q[1] = a[0] * b[1] + a[1] * b[0] + a[2] * b[3] - a[3] * b[2];
+		q[2] = a[0] * b[2] - a[1] * b[3] + a[2] * b[0] + a[3] * b[1];
+		q[3] = a[0] * b[3] + a[1] * b[2] - a[2] * b[1] + a[3] * b[0];
+	}
+
+	// out = q v q*, q unit w x y z
+	void rotate(const double q[4], const double v[3], double out[3])
+	{
+		// v + 2w (u x v) + 2 u x (u x v), u = q.xyz
+		double tx = 2.0 * (q[2] * v[2] - q[3] * v[1]);
+		double ty = 2.0 * (q[3] * v[0] - q[1] * v[2]);
+		double tz = 2.0 * (q[1] * v[1] - q[2] * v[0]);
+		out[0] = v[0] + q[0] * tx + (q[2] * tz - q[3] * ty);
+		out[1] = v[1] + q[0] * ty + (q[3] * tx - q[1] * tz);
+		out[2] = v[2] + q[0] * tz + (q[1] * ty - q[2] * tx);
+	}
+
+	void cross(const double a[3], const double b[3], double out[3])
+	{
+		out[0] = a[1] * b[2] - a[2] * b[1];
+		out[1] = a[2] * b[0] - a[0] * b[2];
+		out[2] = a[0] * b[1] - a[1] * b[0];
+	}
+
+	// rates of a point at lever arm r (pose space) on the rigid body instead of its origin
+	void moveDerivatives(OSVRPoseDerivatives& d, const double r[3])
+	{
+		typedef OSVRPoseDerivatives D;
+		double t[3], u[3];
+		if ((d.flags & D::ANGULAR_VELOCITY) == 0)
+			return;
+		cross(d.angular_velocity, r, t);
+		if (d.flags & D::LINEAR_VELOCITY)
+		{
+			// v + w x r
+			for (int k = 0; k < 3; k++)
+				d.linear_velocity[k] += t[k];
+		}
+		if (d.flags & D::LINEAR_ACCELERATION)
+		{
+			// a + alpha x r + w x (w x r)
+			cross(d.angular_velocity, t, u);
+			for (int k = 0; k < 3; k++)
+				d.linear_acceleration[k] += u[k];
+			if (d.flags & D::ANGULAR_ACCELERATION)
+			{
+				cross(d.angular_acceleration, r, u);
+				for (int k = 0; k < 3; k++)
+					d.linear_acceleration[k] += u[k];
+			}
+		}
+	}
+
+	void rotateDerivatives(OSVRPoseDerivatives& d, const double q[4])
+	{
+		double v[3];
+		rotate(q, d.linear_velocity, v);
+		std::copy(v, v + 3, d.linear_velocity);
+		rotate(q, d.angular_velocity, v);
+		std::copy(v, v + 3, d.angular_velocity);
+		rotate(q, d.linear_acceleration, v);
+		std::copy(v, v + 3, d.linear_acceleration);
+		rotate(q, d.angular_acceleration, v);
+		std::copy(v, v + 3, d.angular_acceleration);
+	}
+}
+
+OSVR_Pose3 OSVRCalibration::identity()
+{
+	OSVR_Pose3 pose;
+	pose.translation.data[0] = pose.translation.data[1] = pose.translation.data[2] = 0.0;
+	pose.rotation.data[0] = 1.0;
+	pose.rotation.data[1] = pose.rotation.data[2] = pose.rotation.data[3] = 0.0;
+	return pose;
+}
+
+OSVR_Pose3 OSVRCalibration::compose(const OSVR_Pose3& a, const OSVR_Pose3& b)
+{
+	OSVR_Pose3 out;
+	rotate(a.rotation.data, b.translation.data, out.translation.data);
+	for (int k = 0; k < 3; k++)
+		out.translation.data[k] += a.translation.data[k];
+	multiply(a.rotation.data, b.rotation.data, out.rotation.data);
+	return out;
+}
+
+void OSVRCalibration::setGlobal(const OSVR_Pose3& transform)
+{
+	global = transform;
+	has_global = true;
+}
+
+void OSVRCalibration::setOffset(uint32_t handle, const OSVR_Pose3& transform)
+{
+	if (offsets.size() <= handle)
+	{
+		offsets.resize(handle + 1, identity());
+		has_offset.resize(handle + 1, 0);
+	}
+	if (has_offset[handle] == 0)
+		num_offsets++;
+	offsets[handle] = transform;
+	has_offset[handle] = 1;
+}
+
+void OSVRCalibration::clearOffset(uint32_t handle)
+{
+	if (handle >= offsets.size() || has_offset[handle] == 0)
+		return;
+	offsets[handle] = identity();
+	has_offset[handle] = 0;
+	num_offsets--;
+}
+
+bool OSVRCalibration::getOffset(uint32_t handle, OSVR_Pose3& transform) const
+{
+	if (handle >= offsets.size() || has_offset[handle] == 0)
+		return false;
+	transform = offsets[handle];
+	return true;
+}
+
+void OSVRCalibration::apply(uint32_t first, uint64_t mask, OSVR_PoseState* states, OSVRPoseDerivatives* derivatives) const
+{
+	for (uint32_t i = 0; mask != 0; i++, mask >>= 1)
+	{
+		if ((mask & 1) == 0)
+			continue;
+		uint32_t handle = first + i;
+		OSVR_PoseState& state = states[i];
+		OSVRPoseDerivatives* d = derivatives && derivatives[i].flags ? &derivatives[i] : nullptr;
+		if (handle < offsets.size() && has_offset[handle])
+		{
+			if (d)
+			{
+				double r[3];
+				rotate(state.rotation.data, offsets[handle].translation.data, r);
+				moveDerivatives(*d, r);
+			}
+			state = compose(state, offsets[handle]);
+		}
+		if (has_global)
+		{
+			if (d)
+				rotateDerivatives(*d, global.rotation.data);
+			state = compose(global, state);
+		}
+	}
+}
+
+void OSVRCalibrationRegistry::set(const OSVRCalibration& calibration)
+{
+	std::lock_guard<std::mutex> guard(write_mutex);
+	std::atomic_store(&current, Ref(std::make_shared<OSVRCalibration>(calibration)));
+}
+
+void OSVRCalibrationRegistry::reset()
+{
+	std::lock_guard<std::mutex> guard(write_mutex);
+	std::atomic_store(&current, Ref());
+}
+
+template <class F>
+void OSVRCalibrationRegistry::modify(F f)
+{
+	// copy on write, the published calibration is never touched again
+	std::lock_guard<std::mutex> guard(write_mutex);
+	Ref old = std::atomic_load(&current);
+	auto next = old ? std::make_shared<OSVRCalibration>(*old) : std::make_shared<OSVRCalibration>();
+	f(*next);
+	std::atomic_store(&current, Ref(next));
+}
+
+void OSVRCalibrationRegistry::setGlobal(const OSVR_Pose3& transform)
+{
+	modify([&](OSVRCalibration& c) { c.setGlobal(transform); });
+}
+
+void OSVRCalibrationRegistry::setOffset(uint32_t handle, const OSVR_Pose3& transform)
+{
+	modify([&](OSVRCalibration& c) { c.setOffset(handle, transform); });
+}
+
+void OSVRCalibrationRegistry::clearOffset(uint32_t handle)
+{
+	modify([&](OSVRCalibration& c) { c.clearOffset(handle); });
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+
+// ignore conflict define
+#pragma push_macro("ignore")
+#undef near
+#undef far
+#include "osvr/ClientKit/InterfaceStateC.h"
+#pragma pop_macro("ignore")
+
+#include "OSVRPoseTable.h"
+
+// tracker to world calibration, applied to every report as it is ingested
+//
+// a calibrated pose is global * pose * offset: global aligns the tracking space with the
+// room, an interface's offset moves its pose from the tracker to the point of the prop
+// that matters (a tip, a grip). transforms are OSVR_Pose3, rotation w, x, y, z.
+
+class OSVRCalibration
+{
+public:
+	static OSVR_Pose3 identity();
+
+	// a * b, b applied first
+	static OSVR_Pose3 compose(const OSVR_Pose3& a, const OSVR_Pose3& b);
+
+	void setGlobal(const OSVR_Pose3& transform);
+	const OSVR_Pose3& getGlobal() const { return global; }
+
+	void setOffset(uint32_t handle, const OSVR_Pose3& transform);
+	void clearOffset(uint32_t handle);
+	// false when the interface has no offset
+	bool getOffset(uint32_t handle, OSVR_Pose3& transform) const;
+
+	// nothing to apply
+	bool isIdentity() const { return has_global == false && num_offsets == 0; }
+
+	// transforms states[i] for every bit i in mask in place, slot i is handle first + i.
+	// derivatives, if given, are rotated into world space and moved to the offset point
+	void apply(uint32_t first, uint64_t mask, OSVR_PoseState* states, OSVRPoseDerivatives* derivatives = nullptr) const;
+
+private:
+	OSVR_Pose3 global = identity();
+	bool has_global = false;
+	std::vector<OSVR_Pose3> offsets; // by handle
+	std::vector<uint8_t> has_offset;
+	size_t num_offsets = 0;
+};
+
+// the calibration in use, swapped as a whole
+//
+// every change publishes a new immutable OSVRCalibration, so the poll thread sees either
+// the old calibration or the new one and never a mix of both. thread-safe.
+class OSVRCalibrationRegistry
+{
+public:
+	using Ref = std::shared_ptr<const OSVRCalibration>;
+
+	// nullptr until the first change
+	Ref get() const { return std::atomic_load(&current); }
+
+	// replaces everything at once, e.g. after recalibrating the room and every prop
+	void set(const OSVRCalibration& calibration);
+	void reset();
+
+	// change one transform of the current calibration
+	void setGlobal(const OSVR_Pose3& transform);
+	void setOffset(uint32_t handle, const OSVR_Pose3& transform);
+	void clearOffset(uint32_t handle);
+
+private:
+	template <class F>
+	void modify(F f);
+
+	std::mutex write_mutex; // orders writers, readers never take it
+	Ref current;
+};
@@ -0,0 +1,59 @@
+#include "OSVRCamera.h"
+
+#include "OSVRCameraBlock.h"
+
+void OSVRCamera::update(const std::map<uint32_t, Viewer>& viewers, RenderTarget target, std::vector<OSVRCamera>& cameras)
+{
+	size_t count = 0;
+	for (auto& vi : viewers)
+	{
+		for (auto& eye : vi.second.eyes)
+		{
+			for (auto& sf : eye.second.surfaces)
+			{
+				if (cameras.size() <= count)
+					cameras.emplace_back();
+				OSVRCamera& camera = cameras[count++];
+				camera.set(eye.second, sf.second, target);
+				camera.viewer_id = vi.first;
+				camera.eye_id = eye.first;
+				camera.surface_id = sf.first;
+			}
+		}
+	}
+	cameras.resize(count);
+}
+
+void OSVRCamera::set(const Eye& eye, const Surface& surface, RenderTarget target)
+{
+	// projection followed by a y flip, the column of y negated
+	const float* p = surface.projection_matrix.getPtr();
+	float* out = projection.getPtr();
+	for (int i = 0; i < 16; i++)
+		out[i] = i % 4 == 1 ? -p[i] : p[i];
+
+	view = eye.modelview_matrix;
+	OSVRCameraBlock::multiply(view.getPtr(), projection.getPtr(), view_projection.getPtr());
+
+	ofMatrix4x4 pose;
+	OSVRCameraBlock::invertRigid(view.getPtr(), pose.getPtr());
+	setTransformMatrix(pose);
+
+	viewport = target < OpenSourceVirtualReality::MAX_RENDER_TARGETS ? toOf(surface.pixel_viewports[target]) : surface.viewport;
+}
+
+void OSVRCamera::begin(ofRectangle)
+{
+	ofPushView();
+	ofViewport(viewport, false); // bottom left origin like the pixel viewports
+
+	ofSetMatrixMode(OF_MATRIX_PROJECTION);
+	ofLoadMatrix(projection);
+	ofSetMatrixMode(OF_MATRIX_MODELVIEW);
+	ofLoadMatrix(view);
+}
+
+void OSVRCamera::end()
+{
+	ofPopView();
+}
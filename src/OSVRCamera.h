@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include <map>
+
+#include "OSVR.h"
+
+// an ofCamera for one surface of one eye, ready to begin() without any per-frame math
+//
+// set() copies the surface's pixel viewport for a render target, its projection with the
+// y flip offscreen targets need already applied, and the eye's view matrix. begin() only
+// loads them, so drawing a surface costs one viewport and two matrix loads. the node
+// transform is the eye's world pose, so getGlobalPosition() and friends work as usual.
+class OSVRCamera : public ofCamera
+{
+public:
+	using Viewer = OpenSourceVirtualReality::Viewer;
+	using Eye = OpenSourceVirtualReality::Eye;
+	using Surface = OpenSourceVirtualReality::Surface;
+	using RenderTarget = OpenSourceVirtualReality::RenderTarget;
+
+	// one camera per surface of viewers in viewer, eye, surface order, reusing cameras
+	static void update(const std::map<uint32_t, Viewer>& viewers, RenderTarget target, std::vector<OSVRCamera>& cameras);
+
+	void set(const Eye& eye, const Surface& surface, RenderTarget target);
+
+	// the viewport argument is ignored, the surface has its own
+	virtual void begin(ofRectangle viewport = ofGetCurrentViewport());
+	virtual void end();
+
+	ofMatrix4x4 getProjectionMatrix(ofRectangle viewport = ofGetCurrentViewport()) const { return projection; }
+	ofMatrix4x4 getModelViewMatrix() const { return view; }
+	ofMatrix4x4 getModelViewProjectionMatrix(ofRectangle viewport = ofGetCurrentViewport()) const { return view_projection; }
+	const ofRectangle& getViewport() const { return viewport; }
+
+	uint32_t viewer_id = 0;
+	uint32_t eye_id = 0;
+	uint32_t surface_id = 0;
+
+private:
+	ofMatrix4x4 projection;
+	ofMatrix4x4 view;
+	ofMatrix4x4 view_projection;
+	ofRectangle viewport;
+};
@@ -0,0 +1,49 @@
+#include "OSVRCameraBlock.h"
+
+#include <cstring>
+
+void OSVRCameraBlock::invertRigid(const float m[16], float out[16])
+{
+	// rotation transposed, translation rotated back and negated
+	for (int r = 0; r < 3; r++)
+	{
+		for (int c = 0; c < 3; c++)
+			out[r * 4 + c] = m[c * 4 + r];
+		out[r * 4 + 3] = 0.0f;
+	}
+	for (int c = 0; c < 3; c++)
+		out[12 + c] = -(m[12] * out[c] + m[13] * out[4 + c] + m[14] * out[8 + c]);
+	out[15] = 1.0f;
+}
+
+void OSVRCameraBlock::multiply(const float a[16], const float b[16], float out[16])
+{
+	for (int r = 0; r < 4; r++)
+	{
+		for (int c = 0; c < 4; c++)
+			out[r * 4 + c] = a[r * 4] * b[c] + a[r * 4 + 1] * b[4 + c] + a[r * 4 + 2] * b[8 + c] + a[r * 4 + 3] * b[12 + c];
+	}
+}
+
+void OSVRCameraBlock::fill(OSVRCameraData& camera, const float view[16], const float projection[16], const OSVRViewport& viewport, uint32_t viewer, uint32_t eye, uint32_t surface)
+{
+	std::memcpy(camera.view, view, sizeof(camera.view));
+	invertRigid(view, camera.inverse_view);
+	std::memcpy(camera.projection, projection, sizeof(camera.projection));
+	multiply(view, projection, camera.view_projection);
+
+	camera.position[0] = camera.inverse_view[12];
+	camera.position[1] = camera.inverse_view[13];
+	camera.position[2] = camera.inverse_view[14];
+	camera.position[3] = 1.0f;
+
+	camera.viewport[0] = viewport.x;
+	camera.viewport[1] = viewport.y;
+	camera.viewport[2] = viewport.width;
+	camera.viewport[3] = viewport.height;
+
+	camera.ids[0] = viewer;
+	camera.ids[1] = eye;
+	camera.ids[2] = surface;
+	camera.ids[3] = 0;
+}
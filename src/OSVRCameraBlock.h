@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "OSVRMath.h"
+
+// camera data of every eye and surface in one buffer, uploaded with a single memcpy
+//
+// the layout is std140 and std430 alike: every member is a mat4, vec4 or ivec4/uvec4, so
+// nothing needs padding between them and the array stride is the struct size. matrices
+// are the core's row-major row-vector memory, which GLSL reads as its default
+// column-major mat4 with column vectors. the matching GLSL is
+//
+//   struct OSVRCamera {
+//       mat4 view; mat4 inverse_view; mat4 projection; mat4 view_projection;
+//       vec4 position; ivec4 viewport; uvec4 ids;
+//   };
+//   layout(std140) uniform OSVRCameras { uvec4 count; OSVRCamera cameras[MAX]; };
+
+struct OSVRCameraData
+{
+	float view[16];
+	float inverse_view[16]; // the eye's world pose
+	float projection[16];
+	float view_projection[16]; // projection * view in GLSL
+	float position[4]; // eye in world space, w = 1
+	int32_t viewport[4]; // x, y, width, height in pixels of a render target, bottom left origin
+	uint32_t ids[4]; // viewer, eye, surface, 0
+};
+
+struct OSVRCameraBlockHeader
+{
+	uint32_t count[4]; // cameras, then 0
+};
+
+static_assert(sizeof(OSVRCameraData) == 304 && sizeof(OSVRCameraData) % 16 == 0, "std140 array stride");
+static_assert(sizeof(OSVRCameraBlockHeader) == 16, "cameras start at a vec4 boundary");
+
+namespace OSVRCameraBlock
+{
+	// bytes of a block holding count cameras
+	inline size_t getSize(size_t count) { return sizeof(OSVRCameraBlockHeader) + count * sizeof(OSVRCameraData); }
+
+	// inverse of a rotation and translation, no general 4x4 inverse needed
+	void invertRigid(const float m[16], float out[16]);
+
+	// out = a * b in row-vector order, a applied first
+	void multiply(const float a[16], const float b[16], float out[16]);
+
+	// view and projection in the core's layout, everything else derived from them
+	void fill(OSVRCameraData& camera, const float view[16], const float projection[16], const OSVRViewport& viewport, uint32_t viewer, uint32_t eye, uint32_t surface);
+}
@@ -0,0 +1,148 @@
+#include "OSVRClock.h"
+
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+using namespace std;
+
+void OSVRClockMapper::addSample(const OSVR_TimeValue& remote, Clock::time_point local)
+{
+	if (!has_epoch)
+	{
+		remote_epoch = remote.seconds;
+		local_epoch = local;
+		has_epoch = true;
+	}
+
+	double r = toRemoteSeconds(remote);
+	double l = std::chrono::duration<double>(local - local_epoch).count();
+	Sample sample = { r, l - r };
+	int64_t bucket = int64_t(std::floor(r * 1000.0 / BUCKET_MS));
+
+	if (num_samples == 0)
+	{
+		open = sample;
+		open_bucket = bucket;
+	}
+	else if (bucket > open_bucket)
+	{
+		closeBucket();
+		open = sample;
+		open_bucket = bucket;
+	}
+	else if (bucket == open_bucket && sample.offset < open.offset)
+	{
+		open = sample;
+	}
+	// older buckets are closed, a report that late says nothing new
+
+	num_samples++;
+	last_remote = std::max(last_remote, r);
+
+	// until the first bucket closes the open one is all there is
+	if (num_buckets == 0)
+		intercept = open.offset;
+}
+
+void OSVRClockMapper::reset()
+{
+	num_samples = 0;
+	num_buckets = 0;
+	next_bucket = 0;
+	sum_x = sum_y = sum_xx = sum_xy = 0.0;
+	has_epoch = false;
+	intercept = 0.0;
+	drift = 0.0;
+	last_remote = 0.0;
+}
+
+bool OSVRClockMapper::isValid() const
+{
+	return num_samples >= MIN_SAMPLES;
+}
+
+OSVRClockMapper::Clock::time_point OSVRClockMapper::toSteady(const OSVR_TimeValue& remote) const
+{
+	if (!has_epoch)
+		return Clock::time_point();
+
+	double r = toRemoteSeconds(remote);
+	double l = r + intercept + drift * r;
+	return local_epoch + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(l));
+}
+
+double OSVRClockMapper::getAge(const OSVR_TimeValue& remote, Clock::time_point now) const
+{
+	return std::chrono::duration<double>(now - toSteady(remote)).count();
+}
+
+double OSVRClockMapper::getOffset() const
+{
+	return intercept + drift * last_remote;
+}
+
+double OSVRClockMapper::getDrift() const
+{
+	return drift;
+}
+
+double OSVRClockMapper::toRemoteSeconds(const OSVR_TimeValue& remote) const
+{
+	return double(remote.seconds - remote_epoch) + remote.microseconds * 1e-6;
+}
+
+void OSVRClockMapper::closeBucket()
+{
+	if (num_buckets == WINDOW_SIZE)
+	{
+		const Sample& old = buckets[next_bucket];
+		sum_x -= old.remote;
+		sum_y -= old.offset;
+		sum_xx -= old.remote * old.remote;
+		sum_xy -= old.remote * old.offset;
+	}
+	buckets[next_bucket] = open;
+	sum_x += open.remote;
+	sum_y += open.offset;
+	sum_xx += open.remote * open.remote;
+	sum_xy += open.remote * open.offset;
+	next_bucket = (next_bucket + 1) % WINDOW_SIZE;
+	num_buckets = std::min<size_t>(num_buckets + 1, WINDOW_SIZE);
+
+	if (next_bucket == 0)
+		sumBuckets();
+	fit();
+}
+
+void OSVRClockMapper::sumBuckets()
+{
+	sum_x = sum_y = sum_xx = sum_xy = 0.0;
+	for (size_t i = 0; i < num_buckets; i++)
+	{
+		sum_x += buckets[i].remote;
+		sum_y += buckets[i].offset;
+		sum_xx += buckets[i].remote * buckets[i].remote;
+		sum_xy += buckets[i].remote * buckets[i].offset;
+	}
+}
+
+void OSVRClockMapper::fit()
+{
+	size_t n = num_buckets;
+	if (n >= MIN_DRIFT_BUCKETS)
+	{
+		double mean_x = sum_x / n;
+		double sxx = sum_xx - sum_x * mean_x;
+		double sxy = sum_xy - sum_y * mean_x;
+		if (sxx > 0.0)
+			drift = sxy / sxx;
+	}
+
+	// anchor to the lower envelope: the least delayed report bounds the offset from above.
+	// once per bucket, never per report
+	double min_intercept = std::numeric_limits<double>::max();
+	for (size_t i = 0; i < n; i++)
+		min_intercept = std::min(min_intercept, buckets[i].offset - drift * buckets[i].remote);
+	intercept = min_intercept;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <chrono>
+#include <array>
+#include <cstdint>
+
+#include "osvr/Util/TimeValueC.h"
+
+// maps OSVR report timestamps (server time base) onto std::chrono::steady_clock
+//
+// every new report gives one (report time, local arrival time) pair. the pairs are
+// decimated into buckets of BUCKET_MS report time keeping the least delayed one, and drift
+// is fitted by least squares over a window of WINDOW_SIZE buckets, about 50 s. the fit is
+// then shifted down to the lower envelope of the buckets: transport delay only ever makes
+// a report arrive late, so the earliest arrival is the best estimate of the true offset.
+// drift stays 0 until the window spans MIN_DRIFT_BUCKETS, a shorter one can't tell drift
+// from jitter.
+//
+// not synchronized, the owner guards it together with the poses it timestamps
+class OSVRClockMapper
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	void addSample(const OSVR_TimeValue& remote, Clock::time_point local);
+	void reset();
+
+	// false until enough samples have been collected for a stable offset
+	bool isValid() const;
+
+	// the epoch of Clock, Clock::time_point(), before the first sample
+	Clock::time_point toSteady(const OSVR_TimeValue& remote) const;
+
+	// seconds elapsed since the report was taken, in the local time base
+	double getAge(const OSVR_TimeValue& remote, Clock::time_point now = Clock::now()) const;
+
+	// local minus remote time in seconds, at the latest sample
+	double getOffset() const;
+
+	// rate difference of the two clocks, in seconds per second
+	double getDrift() const;
+
+private:
+	enum {
+		WINDOW_SIZE = 512,
+		BUCKET_MS = 100,
+		MIN_DRIFT_BUCKETS = 100,
+		MIN_SAMPLES = 8
+	};
+
+	struct Sample
+	{
+		double remote; // seconds since remote_epoch
+		double offset; // local - remote, seconds since local_epoch
+	};
+
+	double toRemoteSeconds(const OSVR_TimeValue& remote) const;
+	void closeBucket();
+	void sumBuckets();
+	void fit();
+
+	// least delayed sample of the bucket still filling
+	Sample open;
+	int64_t open_bucket = 0;
+
+	// closed buckets and their running sums for the fit, recomputed whenever the ring
+	// wraps so rounding can't pile up
+	std::array<Sample, WINDOW_SIZE> buckets;
+	size_t num_buckets = 0;
+	size_t next_bucket = 0;
+	double sum_x = 0.0, sum_y = 0.0, sum_xx = 0.0, sum_xy = 0.0;
+
+	uint64_t num_samples = 0;
+	bool has_epoch = false;
+	int64_t remote_epoch = 0;
+	Clock::time_point local_epoch;
+
+	// fitted model: offset(remote) = intercept + drift * remote
+	double intercept = 0.0;
+	double drift = 0.0;
+	double last_remote = 0.0;
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+// optional C++20 coroutine layer, empty unless the compiler supports coroutines
+//
+// awaiting suspends the coroutine on an OSVRWaitQueue node inside its own frame, so any
+// number of coroutines can wait without threads, polling or allocations. the poll thread
+// resumes them when the report arrives, either inline or by handing them to an executor.
+// destroying a coroutine suspended on a report unlinks its node, so it is never resumed;
+// only one whose report is being dispatched right then already belongs to the poll thread.
+// with an executor, destroy on the executor's thread: the destruction waits out a post in
+// flight, after that the executor only has to drop the handle if it was queued already.
+
+#if defined(__cpp_impl_coroutine)
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+#include "OSVRDelegate.h"
+#include "OSVRWaitQueue.h"
+#include "OSVRSession.h"
+
+#define OSVR_HAS_COROUTINES 1
+
+// where a woken coroutine resumes. an empty executor resumes it inline on the poll
+// thread, a scheduler would post the handle to its own queue
+using OSVRExecutor = OSVRDelegate<void(std::coroutine_handle<>)>;
+
+template <class Event>
+class OSVRAwaitable
+{
+public:
+	OSVRAwaitable(OSVRWaitQueue<Event>* queue, uint32_t key, OSVRExecutor executor)
+		:queue(queue)
+		,executor(executor)
+	{
+		waiter.key = key;
+	}
+
+	OSVRAwaitable(const OSVRAwaitable&) = delete;
+	OSVRAwaitable& operator=(const OSVRAwaitable&) = delete;
+
+	// also runs when the frame is destroyed while suspended here
+	~OSVRAwaitable() { queue->cancel(&waiter); }
+
+	bool await_ready() const noexcept { return false; }
+
+	// a key the queue rejects resumes at once with a default event, timestamp 0
+	bool await_suspend(std::coroutine_handle<> handle)
+	{
+		coroutine = handle;
+		waiter.context = this;
+		waiter.resume = [](OSVRWaiter<Event>* w)
+		{
+			auto self = static_cast<OSVRAwaitable*>(w->context);
+			if (self->executor)
+				self->executor(self->coroutine);
+			else
+				self->coroutine.resume();
+		};
+		// the poll thread may resume the coroutine right away, don't touch this afterwards
+		return queue->push(&waiter);
+	}
+
+	Event await_resume() const { return waiter.event; }
+
+private:
+	OSVRWaitQueue<Event>* queue;
+	OSVRExecutor executor;
+	std::coroutine_handle<> coroutine;
+	OSVRWaiter<Event> waiter;
+};
+
+// a lazy sequence produced by a coroutine, for range-for
+template <class T>
+class OSVRGenerator
+{
+public:
+	struct promise_type
+	{
+		const T* value = nullptr;
+		std::exception_ptr error;
+
+		OSVRGenerator get_return_object() { return OSVRGenerator(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		std::suspend_always final_suspend() noexcept { return {}; }
+		std::suspend_always yield_value(const T& v) noexcept { value = &v; return {}; }
+		void return_void() {}
+		void unhandled_exception() { error = std::current_exception(); }
+	};
+
+	class iterator
+	{
+	public:
+		explicit iterator(std::coroutine_handle<promise_type> handle) :handle(handle) {}
+
+		const T& operator*() const { return *handle.promise().value; }
+		iterator& operator++() { advance(handle); return *this; }
+		bool operator==(std::default_sentinel_t) const { return !handle || handle.done(); }
+
+	private:
+		std::coroutine_handle<promise_type> handle;
+	};
+
+	OSVRGenerator(OSVRGenerator&& other) noexcept :handle(std::exchange(other.handle, nullptr)) {}
+	OSVRGenerator& operator=(OSVRGenerator&&) = delete;
+	~OSVRGenerator() { if (handle) handle.destroy(); }
+
+	iterator begin() { advance(handle); return iterator(handle); }
+	std::default_sentinel_t end() { return {}; }
+
+private:
+	explicit OSVRGenerator(std::coroutine_handle<promise_type> handle) :handle(handle) {}
+
+	static void advance(std::coroutine_handle<promise_type> handle)
+	{
+		handle.resume();
+		if (handle.promise().error)
+			std::rethrow_exception(handle.promise().error);
+	}
+
+	std::coroutine_handle<promise_type> handle;
+};
+
+// every sample of a session from the reader's current position, decoded a block at a time
+// as the loop advances
+inline OSVRGenerator<OSVRPoseSample> readSession(OSVRSessionReader& reader)
+{
+	OSVRPoseSample sample;
+	while (reader.next(sample))
+		co_yield sample;
+}
+
+#endif
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// a callable stored inline, for code that must not allocate
+//
+// holds any trivially copyable callable up to Size bytes: function pointers and lambdas
+// capturing pointers or plain values. bigger or non-trivial callables fail to compile
+// instead of falling back to the heap like std::function would.
+template <class Signature, size_t Size = 4 * sizeof(void*)>
+class OSVRDelegate;
+
+template <class R, class... Args, size_t Size>
+class OSVRDelegate<R(Args...), Size>
+{
+public:
+	OSVRDelegate() {}
+
+	template <class F, class = typename std::enable_if<!std::is_same<typename std::decay<F>::type, OSVRDelegate>::value>::type>
+	OSVRDelegate(F f)
+	{
+		static_assert(sizeof(F) <= Size, "callable too big for the delegate, capture a pointer instead");
+		static_assert(alignof(F) <= alignof(Storage), "callable alignment too big for the delegate");
+		static_assert(std::is_trivially_copyable<F>::value, "delegates only hold trivially copyable callables");
+		new (&storage) F(f);
+		invoker = [](const void* p, Args... args) -> R
+		{
+			return (*static_cast<const F*>(p))(std::forward<Args>(args)...);
+		};
+	}
+
+	R operator()(Args... args) const { return invoker(&storage, std::forward<Args>(args)...); }
+
+	explicit operator bool() const { return invoker != nullptr; }
+
+private:
+	using Storage = typename std::aligned_storage<Size, alignof(void*)>::type;
+
+	Storage storage;
+	R(*invoker)(const void*, Args...) = nullptr;
+};
@@ -0,0 +1,50 @@
+#include "OSVREyes.h"
+
+#include "OSVRCalibration.h"
+#include "OSVRPoseBatch.h"
+
+#include <algorithm>
+
+OSVR_Pose3 OSVREyes::invert(const OSVR_Pose3& pose)
+{
+	// conjugate rotation, translation rotated back and negated
+	OSVR_Pose3 rotation = OSVRCalibration::identity();
+	rotation.rotation.data[0] = pose.rotation.data[0];
+	for (int k = 1; k < 4; k++)
+		rotation.rotation.data[k] = -pose.rotation.data[k];
+
+	OSVR_Pose3 translation = OSVRCalibration::identity();
+	for (int k = 0; k < 3; k++)
+		translation.translation.data[k] = -pose.translation.data[k];
+
+	return OSVRCalibration::compose(rotation, translation);
+}
+
+OSVR_Pose3 OSVREyes::toOffset(const OSVR_Pose3& head, const OSVR_Pose3& eye)
+{
+	return OSVRCalibration::compose(invert(head), eye);
+}
+
+void OSVREyes::toViewMatrices(const OSVR_Pose3& head, const OSVR_Pose3* offsets, size_t count, float* matrices)
+{
+	// inverted eye poses in columns, a few at a time, then one batch conversion
+	enum { CHUNK = 16 };
+	double columns[7][CHUNK];
+	for (size_t base = 0; base < count; base += CHUNK)
+	{
+		size_t n = std::min<size_t>(CHUNK, count - base);
+		for (size_t i = 0; i < n; i++)
+		{
+			OSVR_Pose3 view = invert(OSVRCalibration::compose(head, offsets[base + i]));
+			for (int k = 0; k < 3; k++)
+				columns[k][i] = view.translation.data[k];
+			for (int k = 0; k < 4; k++)
+				columns[3 + k][i] = view.rotation.data[k];
+		}
+		OSVRPoseColumns in = {
+			{ columns[0], columns[1], columns[2] },
+			{ columns[3], columns[4], columns[5], columns[6] }
+		};
+		OSVRPoseBatch::toMatrices(in, n, matrices + base * 16);
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+
+// ignore conflict define
+#pragma push_macro("ignore")
+#undef near
+#undef far
+#include "osvr/ClientKit/InterfaceStateC.h"
+#pragma pop_macro("ignore")
+
+// eye view matrices from a head pose and fixed eye offsets
+//
+// an eye's pose is the head pose composed with the eye's offset from the head, which
+// only changes with the display configuration. its view matrix is the inverse of that
+// pose, so with the offsets cached a viewer needs nothing from ClientKit but the head pose.
+namespace OSVREyes
+{
+	OSVR_Pose3 invert(const OSVR_Pose3& pose);
+
+	// offset of eye relative to head, both in the same space
+	OSVR_Pose3 toOffset(const OSVR_Pose3& head, const OSVR_Pose3& eye);
+
+	// 16 floats per eye in the layout of ofMatrix4x4 and OSVRMatrix, the same matrix
+	// ClientKit's getViewMatrix gives for OSVR_MATRIX_ROWMAJOR | OSVR_MATRIX_ROWVECTORS
+	void toViewMatrices(const OSVR_Pose3& head, const OSVR_Pose3* offsets, size_t count, float* matrices);
+}
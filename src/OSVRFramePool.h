@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <cstddef>
+
+// single-writer, multi-reader pool of preallocated frames
+//
+// the writer fills a slot nobody is reading and publishes it with one atomic store.
+// readers pin the latest published slot through a reference count and never block the
+// writer; a slot is only reused once its last reader let go, so its contents (and their
+// allocations) survive from one tick to the next.
+template <class T, size_t N = 4>
+class OSVRFramePool
+{
+	static_assert(N >= 2, "a frame pool needs at least one slot besides the published one");
+
+	struct Slot
+	{
+		T value;
+		std::atomic<int> readers{ 0 };
+	};
+
+public:
+	class Ref
+	{
+	public:
+		Ref() {}
+		Ref(Ref&& other) : slot(other.slot) { other.slot = nullptr; }
+		Ref& operator=(Ref&& other)
+		{
+			if (this != &other)
+			{
+				release();
+				slot = other.slot;
+				other.slot = nullptr;
+			}
+			return *this;
+		}
+		Ref(const Ref&) = delete;
+		Ref& operator=(const Ref&) = delete;
+		~Ref() { release(); }
+
+		explicit operator bool() const { return slot != nullptr; }
+		const T& operator*() const { return slot->value; }
+		const T* operator->() const { return &slot->value; }
+		const T* get() const { return slot ? &slot->value : nullptr; }
+
+		void release()
+		{
+			if (slot)
+				slot->readers.fetch_sub(1);
+			slot = nullptr;
+		}
+
+	private:
+		friend class OSVRFramePool;
+		explicit Ref(Slot* s) : slot(s) {}
+		Slot* slot = nullptr;
+	};
+
+	// writer side, one thread only. returns nullptr when every spare slot is still
+	// pinned by a reader; the caller should skip publishing for this tick
+	T* beginWrite()
+	{
+		int curr = latest.load();
+		for (int i = 0; i < int(N); i++)
+		{
+			int idx = (writing + 1 + i) % int(N);
+			if (idx != curr && slots[idx].readers.load() == 0)
+			{
+				writing = idx;
+				return &slots[idx].value;
+			}
+		}
+		return nullptr;
+	}
+
+	void publish()
+	{
+		latest.store(writing);
+	}
+
+	// lock-free for readers, empty until the first publish
+	Ref acquire()
+	{
+		for (;;)
+		{
+			int idx = latest.load();
+			if (idx < 0)
+				return Ref();
+			Slot& slot = slots[idx];
+			slot.readers.fetch_add(1);
+			// the writer may have started refilling this slot before we pinned it
+			if (latest.load() == idx)
+				return Ref(&slot);
+			slot.readers.fetch_sub(1);
+		}
+	}
+
+private:
+	std::array<Slot, N> slots;
+	std::atomic<int> latest{ -1 };
+	int writing = -1;
+};
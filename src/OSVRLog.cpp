@@ -0,0 +1,50 @@
+#include "OSVRLog.h"
+
+#include <atomic>
+#include <cstdio>
+
+namespace
+{
+	void printHandler(OSVRLogLevel level, const char* module, const char* message)
+	{
+		static const char* names[] = { "verbose", "notice", "warning", "error" };
+		std::fprintf(stderr, "[%s] %s: %s\n", names[level], module, message);
+	}
+
+	std::atomic<OSVRLog::Handler> handler{ printHandler };
+	std::atomic<int> min_level{ OSVR_LOG_NOTICE };
+}
+
+void OSVRLog::setHandler(Handler h)
+{
+	handler = h ? h : printHandler;
+}
+
+void OSVRLog::setLevel(OSVRLogLevel level)
+{
+	min_level = level;
+}
+
+#define OSVR_LOG_FORWARD(level) \
+	va_list args; \
+	va_start(args, format); \
+	write(level, module, format, args); \
+	va_end(args);
+
+void OSVRLog::verbose(const char* module, const char* format, ...) { OSVR_LOG_FORWARD(OSVR_LOG_VERBOSE) }
+void OSVRLog::notice(const char* module, const char* format, ...) { OSVR_LOG_FORWARD(OSVR_LOG_NOTICE) }
+void OSVRLog::warning(const char* module, const char* format, ...) { OSVR_LOG_FORWARD(OSVR_LOG_WARNING) }
+void OSVRLog::error(const char* module, const char* format, ...) { OSVR_LOG_FORWARD(OSVR_LOG_ERROR) }
+
+#undef OSVR_LOG_FORWARD
+
+void OSVRLog::write(OSVRLogLevel level, const char* module, const char* format, va_list args)
+{
+	if (level < min_level)
+		return;
+
+	// no allocation, long messages are truncated
+	char message[512];
+	std::vsnprintf(message, sizeof(message), format, args);
+	handler.load()(level, module, message);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdarg>
+
+// logging for the tracking core, which can't depend on ofLog
+//
+// messages are formatted into a fixed buffer and handed to one process-wide handler.
+// the default handler prints to stderr, OpenSourceVirtualReality routes it to ofLog.
+enum OSVRLogLevel
+{
+	OSVR_LOG_VERBOSE,
+	OSVR_LOG_NOTICE,
+	OSVR_LOG_WARNING,
+	OSVR_LOG_ERROR
+};
+
+class OSVRLog
+{
+public:
+	typedef void(*Handler)(OSVRLogLevel level, const char* module, const char* message);
+
+	static void setHandler(Handler handler);
+	static void setLevel(OSVRLogLevel level);
+
+	static void verbose(const char* module, const char* format, ...);
+	static void notice(const char* module, const char* format, ...);
+	static void warning(const char* module, const char* format, ...);
+	static void error(const char* module, const char* format, ...);
+
+private:
+	static void write(OSVRLogLevel level, const char* module, const char* format, va_list args);
+};
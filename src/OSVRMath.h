@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstring>
+
+// plain math types, layout compatible with float arrays so they can be memcpy'd,
+// mapped into shared memory or uploaded as-is
+
+struct OSVRVec3
+{
+	float x, y, z;
+};
+
+struct OSVRQuat
+{
+	float x, y, z, w;
+};
+
+// 16 floats, same layout as ofMatrix4x4 (row-major, row vectors)
+struct OSVRMatrix
+{
+	float m[16];
+};
+
+struct OSVRRect
+{
+	float x, y, width, height;
+};
+
+// memory order a consumer uploads matrices in
+//
+// row-major with row vectors, the layout of ofMatrix4x4 and OSVRMatrix, is the same memory as
+// column-major with column vectors, the layout of GL, Vulkan and std140 mat4. only the other
+// two combinations are its transpose, so only they cost a copy.
+template <bool RowMajor, bool RowVectors>
+struct OSVRMatrixConvention
+{
+	static const bool transposed = RowMajor != RowVectors;
+
+	// in is row-major row-vector, as every matrix the core produces
+	static void copy(const float* in, float* out)
+	{
+		if (transposed)
+		{
+			for (int r = 0; r < 4; r++)
+			{
+				for (int c = 0; c < 4; c++)
+					out[c * 4 + r] = in[r * 4 + c];
+			}
+		}
+		else
+		{
+			std::memcpy(out, in, 16 * sizeof(float));
+		}
+	}
+};
+
+using OSVRRowMajorRowVectors = OSVRMatrixConvention<true, true>; // ofMatrix4x4
+using OSVRColumnMajorColumnVectors = OSVRMatrixConvention<false, false>; // GL, Vulkan, std140
+using OSVRRowMajorColumnVectors = OSVRMatrixConvention<true, false>;
+using OSVRColumnMajorRowVectors = OSVRMatrixConvention<false, true>;
+
+// whole pixels of a render target, origin bottom left like glViewport
+struct OSVRViewport
+{
+	int x, y, width, height;
+};
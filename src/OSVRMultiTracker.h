@@ -0,0 +1,157 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "OSVRThreadedTracker.h"
+
+// one front end over several OSVR servers, e.g. one per tracking zone
+//
+// every server gets its own client context and poll thread, so servers never wait on each
+// other. interfaces and viewers of all servers share one handle space: the server index
+// sits above SERVER_SHIFT, the server's own handle or viewer id below it. servers can be
+// added while others are polled and are never removed before the front end goes away.
+template <class Tracker>
+class OSVRMultiTracker
+{
+public:
+	typedef uint32_t Handle;
+	static const Handle INVALID_HANDLE = ~0u;
+
+	enum {
+		SERVER_SHIFT = 24,
+		MAX_SERVERS = 128
+	};
+
+	using Core = typename Tracker::TrackingCore;
+	using Vec3 = typename Core::Vec3;
+	using Quat = typename Core::Quat;
+	using Clock = typename Core::Clock;
+	using Viewer = typename Core::Viewer;
+	using InterfacePose = typename Core::InterfacePose;
+	using FrameRef = typename Core::FrameRef;
+
+	static Handle makeHandle(uint32_t server, uint32_t local) { return (server << SERVER_SHIFT) | local; }
+	static uint32_t getServerIndex(Handle handle) { return handle >> SERVER_SHIFT; }
+	static uint32_t getLocalHandle(Handle handle) { return handle & ((1u << SERVER_SHIFT) - 1); }
+
+	OSVRMultiTracker(std::string applicationIdentifier)
+		:app_identifier(applicationIdentifier)
+	{
+		for (auto& s : servers)
+			s.store(nullptr, std::memory_order_relaxed);
+	}
+
+	~OSVRMultiTracker()
+	{
+		for (auto& s : servers)
+			delete s.load(std::memory_order_relaxed);
+	}
+
+	OSVRMultiTracker(const OSVRMultiTracker&) = delete;
+	OSVRMultiTracker& operator=(const OSVRMultiTracker&) = delete;
+
+	// starts polling the server on host ("" for the local one), returns its index or
+	// INVALID_HANDLE when MAX_SERVERS are in use. never auto-starts a server
+	uint32_t addServer(const std::string& host, const OSVRThreadOptions& options = OSVRThreadOptions())
+	{
+		std::lock_guard<std::mutex> guard(add_mutex);
+		uint32_t index = num_servers.load(std::memory_order_relaxed);
+		if (index == MAX_SERVERS)
+		{
+			OSVRLog::error("OSVR", "too many servers, dropping: %s", host.c_str());
+			return INVALID_HANDLE;
+		}
+		servers[index].store(new Tracker(app_identifier, false, options, host), std::memory_order_release);
+		num_servers.store(index + 1, std::memory_order_release);
+		return index;
+	}
+
+	uint32_t getNumServers() const { return num_servers.load(std::memory_order_acquire); }
+
+	// nullptr for an unknown index
+	Tracker* getServer(uint32_t server) const
+	{
+		return server < getNumServers() ? servers[server].load(std::memory_order_acquire) : nullptr;
+	}
+
+	// same path on the same server gives the same handle
+	Handle addInterface(uint32_t server, const std::string& path)
+	{
+		Tracker* tracker = getServer(server);
+		if (tracker == nullptr)
+			return INVALID_HANDLE;
+		auto local = tracker->addInterface(path);
+		return local == Core::INVALID_INTERFACE || local >= (1u << SERVER_SHIFT) ? INVALID_HANDLE : makeHandle(server, local);
+	}
+
+	bool getInterfacePose(Handle handle, Vec3& translation, Quat& rotation)
+	{
+		Tracker* tracker = getServer(getServerIndex(handle));
+		return tracker && tracker->getInterfacePose(getLocalHandle(handle), translation, rotation);
+	}
+
+	bool getInterfacePose(Handle handle, Vec3& translation, Quat& rotation, typename Clock::time_point& timestamp)
+	{
+		Tracker* tracker = getServer(getServerIndex(handle));
+		return tracker && tracker->getInterfacePose(getLocalHandle(handle), translation, rotation, timestamp);
+	}
+
+	// the latest frame of every server, indexed by server. lock-free, each frame is held
+	// for as long as the set is
+	struct FrameSet
+	{
+		std::vector<FrameRef> frames;
+
+		// nullptr while the server has no frame or no such interface yet
+		const InterfacePose* getPose(Handle handle) const
+		{
+			uint32_t server = getServerIndex(handle);
+			uint32_t local = getLocalHandle(handle);
+			if (server >= frames.size() || !frames[server] || local >= frames[server]->poses.size())
+				return nullptr;
+			return &frames[server]->poses[local];
+		}
+	};
+
+	// reuses the set's vector, so a warm set is never reallocated
+	void captureFrames(FrameSet& set)
+	{
+		uint32_t count = getNumServers();
+		set.frames.resize(count);
+		for (uint32_t i = 0; i < count; i++)
+			set.frames[i] = servers[i].load(std::memory_order_acquire)->captureFrame();
+	}
+
+	FrameSet captureFrames()
+	{
+		FrameSet set;
+		captureFrames(set);
+		return set;
+	}
+
+	// viewers of every server, keyed by makeHandle(server, viewer id). each server updates
+	// its own key range of out in place, so a warm map is never reallocated
+	void getViewers(std::map<uint32_t, Viewer>& out)
+	{
+		uint32_t count = getNumServers();
+		for (uint32_t i = 0; i < count; i++)
+			servers[i].load(std::memory_order_acquire)->getViewers(out, makeHandle(i, 0), 1u << SERVER_SHIFT);
+		// servers are never removed, only keys of a caller's earlier use can lie beyond them
+		out.erase(out.lower_bound(makeHandle(count, 0)), out.end());
+	}
+
+private:
+	std::string app_identifier;
+	std::array<std::atomic<Tracker*>, MAX_SERVERS> servers;
+	std::atomic<uint32_t> num_servers{ 0 };
+	std::mutex add_mutex;
+};
+
+// headless default, see OSVRTracker
+using OSVRMultiServerTracker = OSVRMultiTracker<OSVRTracker>;
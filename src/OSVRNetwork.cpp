@@ -0,0 +1,467 @@
+#include "OSVRNetwork.h"
+#include "OSVRQuantize.h"
+#include "OSVRLog.h"
+
+#include <cstring>
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "Ws2_32.lib")
+#endif
+typedef int socklen_t;
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+	const char* module = "OSVR";
+
+	struct Writer
+	{
+		uint8_t* ptr;
+		uint8_t* end;
+
+		bool fits(size_t n) const { return size_t(end - ptr) >= n; }
+		void u8(uint8_t v) { *ptr++ = v; }
+		void u16(uint16_t v) { for (int i = 0; i < 2; i++) *ptr++ = uint8_t(v >> (8 * i)); }
+		void u32(uint32_t v) { for (int i = 0; i < 4; i++) *ptr++ = uint8_t(v >> (8 * i)); }
+		void u48(uint64_t v) { for (int i = 0; i < 6; i++) *ptr++ = uint8_t(v >> (8 * i)); }
+		void u64(uint64_t v) { for (int i = 0; i < 8; i++) *ptr++ = uint8_t(v >> (8 * i)); }
+		void bytes(const void* data, size_t n) { memcpy(ptr, data, n); ptr += n; }
+	};
+
+	struct Reader
+	{
+		const uint8_t* ptr;
+		const uint8_t* end;
+		bool ok = true;
+
+		bool need(size_t n) { ok = ok && size_t(end - ptr) >= n; return ok; }
+		uint64_t le(int n) { uint64_t v = 0; if (need(n)) { for (int i = 0; i < n; i++) v |= uint64_t(ptr[i]) << (8 * i); ptr += n; } return v; }
+		uint8_t u8() { return uint8_t(le(1)); }
+		uint16_t u16() { return uint16_t(le(2)); }
+		uint32_t u32() { return uint32_t(le(4)); }
+		uint64_t u48() { return le(6); }
+		uint64_t u64() { return le(8); }
+		const uint8_t* bytes(size_t n) { const uint8_t* p = ptr; if (need(n)) ptr += n; return p; }
+		int64_t varint() { int64_t v = 0; const uint8_t* p = ok ? OSVRVarint::getSigned(ptr, end, v) : nullptr; ok = p != nullptr; if (ok) ptr = p; return v; }
+	};
+
+	enum {
+		RECORD_VALID = 1,
+		HEADER_SIZE = 2 + 1 + 1 + 4 + 4 + 8 + 2
+	};
+
+	bool isNewer(uint32_t a, uint32_t b)
+	{
+		return int32_t(a - b) > 0;
+	}
+
+	bool initSockets()
+	{
+#ifdef _WIN32
+		static bool initialized = false;
+		if (!initialized)
+		{
+			WSADATA data;
+			initialized = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+		}
+		return initialized;
+#else
+		return true;
+#endif
+	}
+
+	void closeSocket(intptr_t sock)
+	{
+#ifdef _WIN32
+		closesocket(SOCKET(sock));
+#else
+		::close(int(sock));
+#endif
+	}
+}
+
+size_t OSVRPosePacket::encode(uint8_t* out, size_t capacity, uint32_t seq, uint32_t keyframe_seq, const OSVRPoseSample* samples, size_t count, double precision, vector<int32_t>& keyframe_positions)
+{
+	bool keyframe = seq == keyframe_seq;
+	if (count > 0xffff)
+		return 0;
+
+	int64_t time_base = 0;
+	for (size_t i = 0; i < count; i++)
+		time_base = std::max(time_base, samples[i].timestamp);
+
+	Writer w{ out, out + capacity };
+	if (!w.fits(HEADER_SIZE))
+		return 0;
+	w.u16(MAGIC);
+	w.u8(VERSION);
+	w.u8(keyframe ? FLAG_KEYFRAME : 0);
+	w.u32(seq);
+	w.u32(keyframe_seq);
+	w.u64(uint64_t(time_base));
+	w.u16(uint16_t(count));
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const OSVRPoseSample& s = samples[i];
+		if (s.handle > 0xffff)
+			return 0;
+
+		int32_t position[3];
+		for (int k = 0; k < 3; k++)
+			position[k] = OSVRQuantize::packPosition(s.translation[k], precision);
+
+		uint8_t flags = s.valid ? RECORD_VALID : 0;
+		int32_t* base = nullptr;
+		if (keyframe)
+		{
+			if (keyframe_positions.size() < (s.handle + 1) * 3)
+				keyframe_positions.resize((s.handle + 1) * 3, 0);
+			std::copy(position, position + 3, &keyframe_positions[s.handle * 3]);
+		}
+		else
+		{
+			if (keyframe_positions.size() < (s.handle + 1) * 3)
+				return 0; // interface missing from the keyframe, caller sends a new one
+			base = &keyframe_positions[s.handle * 3];
+		}
+
+		size_t path_length = keyframe ? std::min<size_t>(strlen(s.path), 255) : 0;
+		size_t record = 2 + 1 + (keyframe ? 1 + path_length : 0) + 6 + 4 * OSVRVarint::MAX_SIZE;
+		if (!w.fits(record))
+			return 0;
+
+		w.u16(uint16_t(s.handle));
+		w.u8(flags);
+		if (keyframe)
+		{
+			w.u8(uint8_t(path_length));
+			w.bytes(s.path, path_length);
+		}
+		w.u48(OSVRQuantize::packQuat(s.rotation));
+		for (int k = 0; k < 3; k++)
+			w.ptr = OSVRVarint::putSigned(w.ptr, keyframe ? position[k] : int64_t(position[k]) - base[k]);
+		w.ptr = OSVRVarint::putSigned(w.ptr, time_base - s.timestamp);
+	}
+	return size_t(w.ptr - out);
+}
+
+bool OSVRPosePublisher::open(const string& host, uint16_t port, int keyframeInterval, double prec)
+{
+	close();
+	if (!initSockets())
+		return false;
+
+	intptr_t s = intptr_t(socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP));
+	if (s < 0)
+	{
+		OSVRLog::error(module, "could not create publisher socket");
+		return false;
+	}
+
+	int broadcast = 1;
+	setsockopt(s, SOL_SOCKET, SO_BROADCAST, (const char*)&broadcast, sizeof(broadcast));
+
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1)
+	{
+		OSVRLog::error(module, "invalid publisher address: %s", host.c_str());
+		closeSocket(s);
+		return false;
+	}
+
+	address.assign((uint8_t*)&addr, (uint8_t*)&addr + sizeof(addr));
+	buffer.resize(OSVRPosePacket::MAX_SIZE);
+	keyframe_positions.clear();
+	keyframe_interval = std::max(1, keyframeInterval);
+	precision = prec;
+	sock = s;
+	OSVRLog::notice(module, "publishing poses to %s:%u", host.c_str(), unsigned(port));
+	return true;
+}
+
+void OSVRPosePublisher::close()
+{
+	if (sock == INVALID_SOCKET_VALUE)
+		return;
+	closeSocket(sock);
+	sock = INVALID_SOCKET_VALUE;
+}
+
+bool OSVRPosePublisher::send(const OSVRPoseSample* samples, size_t count)
+{
+	if (sock == INVALID_SOCKET_VALUE)
+		return false;
+
+	seq++;
+	if (seq - keyframe_seq >= uint32_t(keyframe_interval) || keyframe_positions.empty())
+		keyframe_seq = seq;
+
+	size_t size = OSVRPosePacket::encode(buffer.data(), buffer.size(), seq, keyframe_seq, samples, count, precision, keyframe_positions);
+	if (size == 0 && keyframe_seq != seq)
+	{
+		// a new interface showed up since the last keyframe
+		keyframe_seq = seq;
+		size = OSVRPosePacket::encode(buffer.data(), buffer.size(), seq, keyframe_seq, samples, count, precision, keyframe_positions);
+	}
+	if (size == 0)
+		return false;
+
+	return sendto(sock, (const char*)buffer.data(), int(size), 0, (const sockaddr*)address.data(), socklen_t(address.size())) == int(size);
+}
+
+bool OSVRPoseReceiver::open(uint16_t port, double prec, const string& multicastGroup)
+{
+	close();
+	if (!initSockets())
+		return false;
+
+	intptr_t s = intptr_t(socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP));
+	if (s < 0)
+	{
+		OSVRLog::error(module, "could not create receiver socket");
+		return false;
+	}
+
+	int reuse = 1;
+	setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (::bind(s, (const sockaddr*)&addr, sizeof(addr)) != 0)
+	{
+		OSVRLog::error(module, "could not bind receiver to port %u", unsigned(port));
+		closeSocket(s);
+		return false;
+	}
+
+	if (multicastGroup.empty() == false)
+	{
+		ip_mreq group;
+		memset(&group, 0, sizeof(group));
+		inet_pton(AF_INET, multicastGroup.c_str(), &group.imr_multiaddr);
+		group.imr_interface.s_addr = htonl(INADDR_ANY);
+		setsockopt(s, IPPROTO_IP, IP_ADD_MEMBERSHIP, (const char*)&group, sizeof(group));
+	}
+
+	// wake up now and then to notice close()
+#ifdef _WIN32
+	DWORD timeout = 100;
+#else
+	timeval timeout = { 0, 100000 };
+#endif
+	setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+
+	precision = prec;
+	sock = s;
+	is_thread_running = true;
+	thd = std::thread(&OSVRPoseReceiver::threadFunction, this);
+	return true;
+}
+
+void OSVRPoseReceiver::close()
+{
+	if (is_thread_running == false && thd.joinable() == false)
+		return;
+	is_thread_running = false;
+	if (thd.joinable())
+		thd.join();
+	closeSocket(sock);
+	sock = -1;
+}
+
+void OSVRPoseReceiver::threadFunction()
+{
+	std::vector<uint8_t> buffer(OSVRPosePacket::MAX_SIZE);
+	while (is_thread_running)
+	{
+		int size = int(recvfrom(sock, (char*)buffer.data(), int(buffer.size()), 0, nullptr, nullptr));
+		if (size > 0)
+			receive(buffer.data(), size_t(size));
+	}
+}
+
+OSVRPoseReceiver::InterfaceHandle OSVRPoseReceiver::addInterface(const string& path)
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	for (InterfaceHandle i = 0; i < paths.size(); i++)
+	{
+		if (paths[i] == path)
+			return i;
+	}
+	paths.push_back(path);
+	poses.push_back(Pose());
+	return InterfaceHandle(paths.size() - 1);
+}
+
+OSVRPoseReceiver::InterfaceHandle OSVRPoseReceiver::findLocal(const char* path, size_t length)
+{
+	for (InterfaceHandle i = 0; i < paths.size(); i++)
+	{
+		if (paths[i].size() == length && paths[i].compare(0, length, path, length) == 0)
+			return i;
+	}
+	return INVALID_INTERFACE;
+}
+
+bool OSVRPoseReceiver::receive(const uint8_t* data, size_t size)
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	Reader r{ data, data + size };
+
+	uint16_t magic = r.u16();
+	uint8_t version = r.u8();
+	uint8_t flags = r.u8();
+	uint32_t seq = r.u32();
+	uint32_t packet_keyframe = r.u32();
+	int64_t time_base = int64_t(r.u64());
+	uint16_t count = r.u16();
+	if (!r.ok || magic != OSVRPosePacket::MAGIC || version != OSVRPosePacket::VERSION)
+	{
+		stats.malformed++;
+		return false;
+	}
+
+	stats.packets++;
+	if (has_seq)
+	{
+		if (isNewer(seq, last_seq) == false)
+		{
+			stats.reordered++;
+			return false;
+		}
+		stats.lost += seq - last_seq - 1;
+	}
+
+	bool keyframe = (flags & OSVRPosePacket::FLAG_KEYFRAME) != 0;
+	if (!keyframe && (!has_keyframe || packet_keyframe != keyframe_seq))
+	{
+		// still accepted as the newest sequence, the next keyframe recovers
+		has_seq = true;
+		last_seq = seq;
+		stats.no_keyframe++;
+		return false;
+	}
+
+	for (uint16_t i = 0; i < count && r.ok; i++)
+	{
+		uint16_t handle = r.u16();
+		uint8_t record_flags = r.u8();
+
+		if (remotes.size() <= handle)
+			remotes.resize(handle + 1);
+		Remote& remote = remotes[handle];
+
+		if (keyframe)
+		{
+			uint8_t length = r.u8();
+			const uint8_t* path = r.bytes(length);
+			if (!r.ok)
+				break;
+			remote.local = findLocal((const char*)path, length);
+		}
+
+		float rotation[4];
+		OSVRQuantize::unpackQuat(r.u48(), rotation);
+
+		int64_t position[3];
+		for (int k = 0; k < 3; k++)
+		{
+			position[k] = r.varint();
+			if (!keyframe)
+				position[k] += remote.keyframe_position[k];
+		}
+		int64_t timestamp = time_base - r.varint();
+		if (!r.ok)
+			break;
+
+		if (keyframe)
+		{
+			for (int k = 0; k < 3; k++)
+				remote.keyframe_position[k] = int32_t(position[k]);
+			remote.has_keyframe = true;
+		}
+		else if (!remote.has_keyframe)
+			continue;
+
+		if (remote.local == INVALID_INTERFACE)
+			continue;
+		Pose& pose = poses[remote.local];
+		pose.translation = { float(OSVRQuantize::unpackPosition(int32_t(position[0]), precision)), float(OSVRQuantize::unpackPosition(int32_t(position[1]), precision)), float(OSVRQuantize::unpackPosition(int32_t(position[2]), precision)) };
+		pose.rotation = { rotation[0], rotation[1], rotation[2], rotation[3] };
+		pose.timestamp = timestamp;
+		pose.valid = (record_flags & RECORD_VALID) != 0;
+	}
+
+	if (!r.ok)
+	{
+		stats.malformed++;
+		return false;
+	}
+
+	if (keyframe)
+	{
+		keyframe_seq = seq;
+		has_keyframe = true;
+	}
+	has_seq = true;
+	last_seq = seq;
+	return true;
+}
+
+bool OSVRPoseReceiver::getInterfacePose(InterfaceHandle handle, OSVRVec3& translation, OSVRQuat& rotation)
+{
+	int64_t timestamp;
+	return getInterfacePose(handle, translation, rotation, timestamp);
+}
+
+bool OSVRPoseReceiver::getInterfacePose(InterfaceHandle handle, OSVRVec3& translation, OSVRQuat& rotation, int64_t& timestamp)
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	if (handle >= poses.size() || poses[handle].valid == false)
+		return false;
+	translation = poses[handle].translation;
+	rotation = poses[handle].rotation;
+	timestamp = poses[handle].timestamp;
+	return true;
+}
+
+bool OSVRPoseReceiver::getInterfacePose(const string& path, OSVRVec3& translation, OSVRQuat& rotation)
+{
+	InterfaceHandle handle;
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		handle = findLocal(path.c_str(), path.size());
+	}
+	if (handle == INVALID_INTERFACE)
+	{
+		OSVRLog::warning(module, "interface is not found with path: %s", path.c_str());
+		return false;
+	}
+	return getInterfacePose(handle, translation, rotation);
+}
+
+OSVRNetworkStats OSVRPoseReceiver::getStats()
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	return stats;
+}
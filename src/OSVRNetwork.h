@@ -0,0 +1,130 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+#include "OSVRMath.h"
+#include "OSVRPoseCodec.h"
+
+// compact pose fan-out over UDP, one tracking PC driving many render nodes
+//
+// every tick becomes one datagram: a header with a sequence number followed by one record
+// per interface, rotation packed as smallest-three and position in fixed point. every
+// keyframe_interval packets a keyframe carries absolute positions and interface paths; the
+// packets in between carry positions as varint deltas (see OSVRPoseCodec.h) against that
+// keyframe, never against the previous packet, so a lost delta costs nothing and a lost keyframe only stalls until
+// the next one. receivers drop anything older than what they already applied.
+
+struct OSVRNetworkStats
+{
+	uint64_t packets = 0;
+	uint64_t lost = 0;        // sequence gaps
+	uint64_t reordered = 0;   // arrived after a newer packet, dropped
+	uint64_t no_keyframe = 0; // deltas against a keyframe we never got
+	uint64_t malformed = 0;
+};
+
+namespace OSVRPosePacket
+{
+	enum {
+		MAGIC = 0x504f,
+		VERSION = 2,
+		MAX_SIZE = 65507,
+		FLAG_KEYFRAME = 1
+	};
+
+	// fills `out` and returns its size, 0 when the samples don't fit in one datagram
+	size_t encode(uint8_t* out, size_t capacity, uint32_t seq, uint32_t keyframe_seq, const OSVRPoseSample* samples, size_t count, double precision, std::vector<int32_t>& keyframe_positions);
+}
+
+class OSVRPosePublisher
+{
+public:
+	~OSVRPosePublisher() { close(); }
+
+	// host may be a unicast, broadcast or multicast address
+	bool open(const std::string& host, uint16_t port, int keyframeInterval = 60, double precision = 0.0001);
+	void close();
+	bool isOpen() const { return sock != INVALID_SOCKET_VALUE; }
+
+	bool send(const OSVRPoseSample* samples, size_t count);
+
+	uint32_t getSequence() const { return seq; }
+
+private:
+	static const intptr_t INVALID_SOCKET_VALUE = -1;
+
+	intptr_t sock = INVALID_SOCKET_VALUE;
+	std::vector<uint8_t> address; // sockaddr_in
+	std::vector<uint8_t> buffer;
+	std::vector<int32_t> keyframe_positions; // quantized, by sender handle
+	int keyframe_interval = 60;
+	double precision = 0.0001;
+	uint32_t seq = 0;
+	uint32_t keyframe_seq = 0;
+};
+
+// the receiving end, the same handle and getInterfacePose API as the tracking core
+class OSVRPoseReceiver
+{
+public:
+	typedef uint32_t InterfaceHandle;
+	static const InterfaceHandle INVALID_INTERFACE = ~0u;
+
+	~OSVRPoseReceiver() { close(); }
+
+	// listens on its own thread until close()
+	bool open(uint16_t port, double precision = 0.0001, const std::string& multicastGroup = "");
+	void close();
+
+	// the handle resolves once a keyframe naming this path arrived
+	InterfaceHandle addInterface(const std::string& path);
+
+	bool getInterfacePose(InterfaceHandle handle, OSVRVec3& translation, OSVRQuat& rotation);
+	bool getInterfacePose(InterfaceHandle handle, OSVRVec3& translation, OSVRQuat& rotation, int64_t& timestamp);
+	bool getInterfacePose(const std::string& path, OSVRVec3& translation, OSVRQuat& rotation);
+
+	OSVRNetworkStats getStats();
+
+	// decodes one datagram, exposed for tests and for custom transports
+	bool receive(const uint8_t* data, size_t size);
+
+private:
+	struct Pose
+	{
+		OSVRVec3 translation;
+		OSVRQuat rotation;
+		int64_t timestamp = 0;
+		bool valid = false;
+	};
+
+	struct Remote
+	{
+		int32_t keyframe_position[3];
+		InterfaceHandle local = INVALID_INTERFACE;
+		bool has_keyframe = false;
+	};
+
+	void threadFunction();
+	InterfaceHandle findLocal(const char* path, size_t length);
+
+	std::mutex mtx;
+	std::thread thd;
+	std::atomic<bool> is_thread_running{ false };
+	intptr_t sock = -1;
+	double precision = 0.0001;
+
+	std::vector<std::string> paths; // by local handle
+	std::vector<Pose> poses;        // by local handle
+	std::vector<Remote> remotes;    // by sender handle
+
+	bool has_seq = false;
+	uint32_t last_seq = 0;
+	uint32_t keyframe_seq = 0;
+	bool has_keyframe = false;
+	OSVRNetworkStats stats;
+};
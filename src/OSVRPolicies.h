@@ -0,0 +1,269 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <vector>
+#include <array>
+#include <map>
+#include <cstdint>
+#include <cstring>
+
+#include "OSVRMath.h"
+
+// policies for OSVRTrackingCore
+//
+// lock policies
+//   write(f)     runs f exclusively and makes its changes visible to read()
+//   exclusive(f) runs f exclusively; for state read() never touches (paths, queues)
+//   read(f)      runs f against a consistent view. with optimistic_reads f may run more
+//                than once and must only copy trivially copyable state out
+
+struct MutexLockPolicy
+{
+	static const bool optimistic_reads = false;
+
+	template <class F> void write(F&& f) { std::lock_guard<std::mutex> guard(mtx); f(); }
+	template <class F> void exclusive(F&& f) { std::lock_guard<std::mutex> guard(mtx); f(); }
+	template <class F> void read(F&& f) { std::lock_guard<std::mutex> guard(mtx); f(); }
+
+private:
+	std::mutex mtx;
+};
+
+// readers of the clock mapper never block the poll thread, they retry when a tick landed
+// mid-read. that covers toSteady, getClockOffset, getClockDrift and the timestamped pose
+// getters built on toSteady. everything else read() can't copy safely, the viewer trees
+// and the path lookup, goes through exclusive() and waits for the poll thread like with
+// MutexLockPolicy. pose reads by handle and captureFrame are lock-free under every policy
+struct SeqLockPolicy
+{
+	static const bool optimistic_reads = true;
+
+	template <class F> void write(F&& f)
+	{
+		std::lock_guard<std::mutex> guard(writer);
+		seq.fetch_add(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		f();
+		seq.fetch_add(1, std::memory_order_release);
+	}
+
+	template <class F> void exclusive(F&& f) { std::lock_guard<std::mutex> guard(writer); f(); }
+
+	template <class F> void read(F&& f)
+	{
+		for (;;)
+		{
+			unsigned begin = seq.load(std::memory_order_acquire);
+			if (begin & 1)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			f();
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (seq.load(std::memory_order_relaxed) == begin)
+				return;
+		}
+	}
+
+private:
+	std::mutex writer;
+	std::atomic<unsigned> seq{ 0 };
+};
+
+// single-threaded use, the core is updated and read from the same thread
+struct NullLockPolicy
+{
+	static const bool optimistic_reads = false;
+
+	template <class F> void write(F&& f) { f(); }
+	template <class F> void exclusive(F&& f) { f(); }
+	template <class F> void read(F&& f) { f(); }
+};
+
+// storage policies, Entry must carry a `path` of type Path
+//   Path                 std::string or anything with c_str(), empty() and == std::string
+//   find(path)           entry or nullptr
+//   get(handle)          entry or nullptr when not inserted yet
+//   insert(handle, path) new entry, nullptr when full
+//   forEach(f)           every inserted entry
+
+// a path stored in place, for storage that must not allocate
+template <size_t Size>
+struct OSVRFixedPath
+{
+	char data[Size] = {};
+	size_t length = 0;
+
+	// false for a path of Size characters or more, which is left unchanged
+	bool assign(const std::string& path)
+	{
+		if (path.size() >= Size)
+			return false;
+		std::memcpy(data, path.data(), path.size());
+		data[path.size()] = '\0';
+		length = path.size();
+		return true;
+	}
+
+	const char* c_str() const { return data; }
+	bool empty() const { return length == 0; }
+	bool operator==(const std::string& path) const { return path.size() == length && std::memcmp(data, path.data(), length) == 0; }
+};
+
+struct MapStoragePolicy
+{
+	using Path = std::string;
+
+	template <class Entry>
+	class Store
+	{
+	public:
+		Entry* find(const std::string& path)
+		{
+			auto it = entries.find(path);
+			return it == entries.end() ? nullptr : &it->second;
+		}
+
+		Entry* get(uint32_t handle)
+		{
+			return handle < handles.size() ? handles[handle] : nullptr;
+		}
+
+		Entry* insert(uint32_t handle, const std::string& path)
+		{
+			Entry& entry = entries[path];
+			entry.path = path;
+			if (handles.size() <= handle)
+				handles.resize(handle + 1, nullptr);
+			handles[handle] = &entry;
+			return &entry;
+		}
+
+		template <class F> void forEach(F f)
+		{
+			for (auto& e : entries)
+				f(e.second);
+		}
+
+	private:
+		std::map<std::string, Entry> entries;
+		std::vector<Entry*> handles; // map nodes never move
+	};
+};
+
+// entries stored by handle, path lookup is a linear scan
+struct FlatStoragePolicy
+{
+	using Path = std::string;
+
+	template <class Entry>
+	class Store
+	{
+	public:
+		Entry* find(const std::string& path)
+		{
+			for (auto& e : entries)
+			{
+				if (e.path == path)
+					return &e;
+			}
+			return nullptr;
+		}
+
+		Entry* get(uint32_t handle)
+		{
+			return handle < entries.size() && entries[handle].path.empty() == false ? &entries[handle] : nullptr;
+		}
+
+		Entry* insert(uint32_t handle, const std::string& path)
+		{
+			if (entries.size() <= handle)
+				entries.resize(handle + 1);
+			entries[handle].path = path;
+			return &entries[handle];
+		}
+
+		template <class F> void forEach(F f)
+		{
+			for (auto& e : entries)
+			{
+				if (e.path.empty() == false)
+					f(e);
+			}
+		}
+
+	private:
+		std::vector<Entry> entries;
+	};
+};
+
+// no allocation after construction, interfaces beyond Capacity and paths of MaxPathLength
+// characters or more are rejected
+template <size_t Capacity, size_t MaxPathLength = 128>
+struct FixedStoragePolicy
+{
+	using Path = OSVRFixedPath<MaxPathLength>;
+
+	template <class Entry>
+	class Store
+	{
+	public:
+		Entry* find(const std::string& path)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				if (entries[i].path == path)
+					return &entries[i];
+			}
+			return nullptr;
+		}
+
+		Entry* get(uint32_t handle)
+		{
+			return handle < count && entries[handle].path.empty() == false ? &entries[handle] : nullptr;
+		}
+
+		Entry* insert(uint32_t handle, const std::string& path)
+		{
+			if (handle >= Capacity || entries[handle].path.assign(path) == false)
+				return nullptr;
+			if (count <= handle)
+				count = handle + 1;
+			return &entries[handle];
+		}
+
+		template <class F> void forEach(F f)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				if (entries[i].path.empty() == false)
+					f(entries[i]);
+			}
+		}
+
+	private:
+		std::array<Entry, Capacity> entries;
+		size_t count = 0;
+	};
+};
+
+// math policies, what the core hands out for positions, rotations, matrices and viewports
+
+struct PodMathPolicy
+{
+	using Vec3 = OSVRVec3;
+	using Quat = OSVRQuat;
+	using Matrix = OSVRMatrix;
+	using Rect = OSVRRect;
+
+	static void setVec3(Vec3& v, double x, double y, double z) { v = { float(x), float(y), float(z) }; }
+	static void setQuat(Quat& q, double x, double y, double z, double w) { q = { float(x), float(y), float(z), float(w) }; }
+	static void setRect(Rect& r, double x, double y, double width, double height) { r = { float(x), float(y), float(width), float(height) }; }
+	static float* getPtr(Matrix& m) { return m.m; }
+	static const float* getPtr(const Matrix& m) { return m.m; }
+	static void getRect(const Rect& r, float out[4]) { out[0] = r.x; out[1] = r.y; out[2] = r.width; out[3] = r.height; }
+};
@@ -0,0 +1,375 @@
+#include "OSVRPoseBatch.h"
+
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define OSVR_BATCH_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define OSVR_TARGET_SSE2
+#define OSVR_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define OSVR_TARGET_SSE2 __attribute__((target("sse2")))
+#define OSVR_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// every kernel rounds after each multiply and add. a compiler contracting them into FMA,
+// e.g. with -march=native or -mfma, would do so differently per kernel and break the
+// bit-identical results
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#elif defined(_MSC_VER)
+#pragma fp_contract(off)
+#endif
+
+using namespace OSVRPoseBatch;
+
+namespace
+{
+	// ofMatrix4x4::setRotate, including its 2 / |q|^2 scale for quaternions that aren't unit length
+	void scalarMatrix(const OSVRPoseColumns& in, size_t i, float* m)
+	{
+		float w = float(in.rotation[0][i]);
+		float x = float(in.rotation[1][i]);
+		float y = float(in.rotation[2][i]);
+		float z = float(in.rotation[3][i]);
+
+		float length2 = x * x + y * y + z * z + w * w;
+		float s = length2 > 0.0f ? 2.0f / length2 : 0.0f;
+		float x2 = x * s, y2 = y * s, z2 = z * s;
+		float xx = x * x2, xy = x * y2, xz = x * z2;
+		float yy = y * y2, yz = y * z2, zz = z * z2;
+		float wx = w * x2, wy = w * y2, wz = w * z2;
+
+		m[0] = 1.0f - (yy + zz); m[1] = xy + wz;          m[2] = xz - wy;           m[3] = 0.0f;
+		m[4] = xy - wz;          m[5] = 1.0f - (xx + zz); m[6] = yz + wx;           m[7] = 0.0f;
+		m[8] = xz + wy;          m[9] = yz - wx;          m[10] = 1.0f - (xx + yy); m[11] = 0.0f;
+		m[12] = float(in.translation[0][i]);
+		m[13] = float(in.translation[1][i]);
+		m[14] = float(in.translation[2][i]);
+		m[15] = 1.0f;
+	}
+
+	void scalarPose(const OSVRPoseColumns& in, size_t i, float* positions, float* rotations)
+	{
+		if (positions)
+		{
+			for (int k = 0; k < 3; k++)
+				positions[i * 3 + k] = float(in.translation[k][i]);
+		}
+		if (rotations)
+		{
+			rotations[i * 4 + 0] = float(in.rotation[1][i]);
+			rotations[i * 4 + 1] = float(in.rotation[2][i]);
+			rotations[i * 4 + 2] = float(in.rotation[3][i]);
+			rotations[i * 4 + 3] = float(in.rotation[0][i]);
+		}
+	}
+
+	void scalarMatrices(const OSVRPoseColumns& in, size_t begin, size_t count, float* matrices)
+	{
+		for (size_t i = begin; i < count; i++)
+			scalarMatrix(in, i, matrices + i * 16);
+	}
+
+	void scalarPoses(const OSVRPoseColumns& in, size_t begin, size_t count, float* positions, float* rotations)
+	{
+		for (size_t i = begin; i < count; i++)
+			scalarPose(in, i, positions, rotations);
+	}
+
+#ifdef OSVR_BATCH_X86
+	void cpuid(int leaf, int sub, uint32_t regs[4])
+	{
+#ifdef _MSC_VER
+		int r[4];
+		__cpuidex(r, leaf, sub);
+		for (int i = 0; i < 4; i++)
+			regs[i] = uint32_t(r[i]);
+#else
+		regs[0] = regs[1] = regs[2] = regs[3] = 0;
+		__get_cpuid_count(leaf, sub, &regs[0], &regs[1], &regs[2], &regs[3]);
+#endif
+	}
+
+	uint64_t xgetbv()
+	{
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		uint32_t lo, hi;
+		__asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+		return (uint64_t(hi) << 32) | lo;
+#endif
+	}
+
+	Isa detectIsa()
+	{
+		uint32_t regs[4];
+		cpuid(0, 0, regs);
+		uint32_t max_leaf = regs[0];
+
+		cpuid(1, 0, regs);
+		bool sse2 = (regs[3] & (1u << 26)) != 0;
+		bool osxsave = (regs[2] & (1u << 27)) != 0;
+		bool avx = (regs[2] & (1u << 28)) != 0;
+
+		// the OS must save the ymm registers too
+		if (avx && osxsave && (xgetbv() & 6) == 6 && max_leaf >= 7)
+		{
+			cpuid(7, 0, regs);
+			if (regs[1] & (1u << 5))
+				return ISA_AVX2;
+		}
+		return sse2 ? ISA_SSE2 : ISA_SCALAR;
+	}
+
+	// SSE2, 4 poses at a time
+
+	OSVR_TARGET_SSE2 inline __m128 load4(const double* p)
+	{
+		return _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(p)), _mm_cvtpd_ps(_mm_loadu_pd(p + 2)));
+	}
+
+	OSVR_TARGET_SSE2 inline void transposeStore4(__m128 a, __m128 b, __m128 c, __m128 d, float* out, size_t stride)
+	{
+		_MM_TRANSPOSE4_PS(a, b, c, d);
+		_mm_storeu_ps(out, a);
+		_mm_storeu_ps(out + stride, b);
+		_mm_storeu_ps(out + stride * 2, c);
+		_mm_storeu_ps(out + stride * 3, d);
+	}
+
+	OSVR_TARGET_SSE2 inline void storeVec3(float* out, __m128 v)
+	{
+		_mm_storel_pi((__m64*)out, v);
+		_mm_store_ss(out + 2, _mm_movehl_ps(v, v));
+	}
+
+	OSVR_TARGET_SSE2 void sse2Matrices(const OSVRPoseColumns& in, size_t begin, size_t count, float* matrices)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 two = _mm_set1_ps(2.0f);
+
+		size_t i = begin;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 w = load4(in.rotation[0] + i);
+			__m128 x = load4(in.rotation[1] + i);
+			__m128 y = load4(in.rotation[2] + i);
+			__m128 z = load4(in.rotation[3] + i);
+
+			__m128 length2 = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)), _mm_mul_ps(w, w));
+			__m128 s = _mm_and_ps(_mm_div_ps(two, length2), _mm_cmpgt_ps(length2, zero));
+			__m128 x2 = _mm_mul_ps(x, s), y2 = _mm_mul_ps(y, s), z2 = _mm_mul_ps(z, s);
+			__m128 xx = _mm_mul_ps(x, x2), xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2);
+			__m128 yy = _mm_mul_ps(y, y2), yz = _mm_mul_ps(y, z2), zz = _mm_mul_ps(z, z2);
+			__m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+
+			float* out = matrices + i * 16;
+			transposeStore4(_mm_sub_ps(one, _mm_add_ps(yy, zz)), _mm_add_ps(xy, wz), _mm_sub_ps(xz, wy), zero, out, 16);
+			transposeStore4(_mm_sub_ps(xy, wz), _mm_sub_ps(one, _mm_add_ps(xx, zz)), _mm_add_ps(yz, wx), zero, out + 4, 16);
+			transposeStore4(_mm_add_ps(xz, wy), _mm_sub_ps(yz, wx), _mm_sub_ps(one, _mm_add_ps(xx, yy)), zero, out + 8, 16);
+			transposeStore4(load4(in.translation[0] + i), load4(in.translation[1] + i), load4(in.translation[2] + i), one, out + 12, 16);
+		}
+		scalarMatrices(in, i, count, matrices);
+	}
+
+	OSVR_TARGET_SSE2 void sse2Poses(const OSVRPoseColumns& in, size_t begin, size_t count, float* positions, float* rotations)
+	{
+		size_t i = begin;
+		for (; i + 4 <= count; i += 4)
+		{
+			if (positions)
+			{
+				__m128 x = load4(in.translation[0] + i);
+				__m128 y = load4(in.translation[1] + i);
+				__m128 z = load4(in.translation[2] + i);
+				__m128 pad = _mm_setzero_ps();
+				_MM_TRANSPOSE4_PS(x, y, z, pad);
+				float* out = positions + i * 3;
+				storeVec3(out, x);
+				storeVec3(out + 3, y);
+				storeVec3(out + 6, z);
+				storeVec3(out + 9, pad);
+			}
+			if (rotations)
+			{
+				transposeStore4(load4(in.rotation[1] + i), load4(in.rotation[2] + i), load4(in.rotation[3] + i), load4(in.rotation[0] + i), rotations + i * 4, 4);
+			}
+		}
+		scalarPoses(in, i, count, positions, rotations);
+	}
+
+	// AVX2, 8 poses at a time
+
+	OSVR_TARGET_AVX2 inline __m256 load8(const double* p)
+	{
+		__m256 lo = _mm256_castps128_ps256(_mm256_cvtpd_ps(_mm256_loadu_pd(p)));
+		return _mm256_insertf128_ps(lo, _mm256_cvtpd_ps(_mm256_loadu_pd(p + 4)), 1);
+	}
+
+	// rows r[k] hold component k of 8 poses, afterwards r[p] holds the 8 components of pose p
+	OSVR_TARGET_AVX2 inline void transpose8(__m256 r[8])
+	{
+		__m256 t0 = _mm256_unpacklo_ps(r[0], r[1]), t1 = _mm256_unpackhi_ps(r[0], r[1]);
+		__m256 t2 = _mm256_unpacklo_ps(r[2], r[3]), t3 = _mm256_unpackhi_ps(r[2], r[3]);
+		__m256 t4 = _mm256_unpacklo_ps(r[4], r[5]), t5 = _mm256_unpackhi_ps(r[4], r[5]);
+		__m256 t6 = _mm256_unpacklo_ps(r[6], r[7]), t7 = _mm256_unpackhi_ps(r[6], r[7]);
+		__m256 u0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)), u1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 u2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)), u3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 u4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0)), u5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 u6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0)), u7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+		r[0] = _mm256_permute2f128_ps(u0, u4, 0x20);
+		r[1] = _mm256_permute2f128_ps(u1, u5, 0x20);
+		r[2] = _mm256_permute2f128_ps(u2, u6, 0x20);
+		r[3] = _mm256_permute2f128_ps(u3, u7, 0x20);
+		r[4] = _mm256_permute2f128_ps(u0, u4, 0x31);
+		r[5] = _mm256_permute2f128_ps(u1, u5, 0x31);
+		r[6] = _mm256_permute2f128_ps(u2, u6, 0x31);
+		r[7] = _mm256_permute2f128_ps(u3, u7, 0x31);
+	}
+
+	OSVR_TARGET_AVX2 void avx2Matrices(const OSVRPoseColumns& in, size_t begin, size_t count, float* matrices)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 two = _mm256_set1_ps(2.0f);
+
+		size_t i = begin;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 w = load8(in.rotation[0] + i);
+			__m256 x = load8(in.rotation[1] + i);
+			__m256 y = load8(in.rotation[2] + i);
+			__m256 z = load8(in.rotation[3] + i);
+
+			__m256 length2 = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z)), _mm256_mul_ps(w, w));
+			__m256 s = _mm256_and_ps(_mm256_div_ps(two, length2), _mm256_cmp_ps(length2, zero, _CMP_GT_OQ));
+			__m256 x2 = _mm256_mul_ps(x, s), y2 = _mm256_mul_ps(y, s), z2 = _mm256_mul_ps(z, s);
+			__m256 xx = _mm256_mul_ps(x, x2), xy = _mm256_mul_ps(x, y2), xz = _mm256_mul_ps(x, z2);
+			__m256 yy = _mm256_mul_ps(y, y2), yz = _mm256_mul_ps(y, z2), zz = _mm256_mul_ps(z, z2);
+			__m256 wx = _mm256_mul_ps(w, x2), wy = _mm256_mul_ps(w, y2), wz = _mm256_mul_ps(w, z2);
+
+			__m256 top[8] = {
+				_mm256_sub_ps(one, _mm256_add_ps(yy, zz)), _mm256_add_ps(xy, wz), _mm256_sub_ps(xz, wy), zero,
+				_mm256_sub_ps(xy, wz), _mm256_sub_ps(one, _mm256_add_ps(xx, zz)), _mm256_add_ps(yz, wx), zero
+			};
+			__m256 bottom[8] = {
+				_mm256_add_ps(xz, wy), _mm256_sub_ps(yz, wx), _mm256_sub_ps(one, _mm256_add_ps(xx, yy)), zero,
+				load8(in.translation[0] + i), load8(in.translation[1] + i), load8(in.translation[2] + i), one
+			};
+			transpose8(top);
+			transpose8(bottom);
+
+			float* out = matrices + i * 16;
+			for (int p = 0; p < 8; p++)
+			{
+				_mm256_storeu_ps(out + p * 16, top[p]);
+				_mm256_storeu_ps(out + p * 16 + 8, bottom[p]);
+			}
+		}
+		sse2Matrices(in, i, count, matrices);
+	}
+
+	OSVR_TARGET_AVX2 void avx2Poses(const OSVRPoseColumns& in, size_t begin, size_t count, float* positions, float* rotations)
+	{
+		size_t i = begin;
+		for (; i + 8 <= count; i += 8)
+		{
+			for (int half = 0; half < 2; half++)
+			{
+				size_t j = i + half * 4;
+				if (positions)
+				{
+					__m128 x = load4(in.translation[0] + j);
+					__m128 y = load4(in.translation[1] + j);
+					__m128 z = load4(in.translation[2] + j);
+					__m128 pad = _mm_setzero_ps();
+					_MM_TRANSPOSE4_PS(x, y, z, pad);
+					float* out = positions + j * 3;
+					storeVec3(out, x);
+					storeVec3(out + 3, y);
+					storeVec3(out + 6, z);
+					storeVec3(out + 9, pad);
+				}
+				if (rotations)
+				{
+					transposeStore4(load4(in.rotation[1] + j), load4(in.rotation[2] + j), load4(in.rotation[3] + j), load4(in.rotation[0] + j), rotations + j * 4, 4);
+				}
+			}
+		}
+		sse2Poses(in, i, count, positions, rotations);
+	}
+#endif
+}
+
+Isa OSVRPoseBatch::getBestIsa()
+{
+#ifdef OSVR_BATCH_X86
+	static const Isa best = detectIsa();
+	return best;
+#else
+	return ISA_SCALAR;
+#endif
+}
+
+const char* OSVRPoseBatch::getIsaName(Isa isa)
+{
+	switch (isa)
+	{
+	case ISA_SSE2: return "sse2";
+	case ISA_AVX2: return "avx2";
+	default: return "scalar";
+	}
+}
+
+void OSVRPoseBatch::toMatrices(const OSVRPoseColumns& in, size_t count, float* matrices)
+{
+	toMatrices(in, count, matrices, getBestIsa());
+}
+
+void OSVRPoseBatch::toMatrices(const OSVRPoseColumns& in, size_t count, float* matrices, Isa isa)
+{
+	// never run a kernel the CPU doesn't have
+	if (isa > getBestIsa())
+		isa = getBestIsa();
+#ifdef OSVR_BATCH_X86
+	if (isa == ISA_AVX2)
+		return avx2Matrices(in, 0, count, matrices);
+	if (isa == ISA_SSE2)
+		return sse2Matrices(in, 0, count, matrices);
+#endif
+	scalarMatrices(in, 0, count, matrices);
+}
+
+void OSVRPoseBatch::toVectors(const double* const in[3], size_t count, float* vectors)
+{
+	// the position half of toPoses, the rotation columns are never read without rotations
+	OSVRPoseColumns columns = { { in[0], in[1], in[2] }, { nullptr, nullptr, nullptr, nullptr } };
+	toPoses(columns, count, vectors, nullptr);
+}
+
+void OSVRPoseBatch::toPoses(const OSVRPoseColumns& in, size_t count, float* positions, float* rotations)
+{
+	toPoses(in, count, positions, rotations, getBestIsa());
+}
+
+void OSVRPoseBatch::toPoses(const OSVRPoseColumns& in, size_t count, float* positions, float* rotations, Isa isa)
+{
+	if (isa > getBestIsa())
+		isa = getBestIsa();
+#ifdef OSVR_BATCH_X86
+	if (isa == ISA_AVX2)
+		return avx2Poses(in, 0, count, positions, rotations);
+	if (isa == ISA_SSE2)
+		return sse2Poses(in, 0, count, positions, rotations);
+#endif
+	scalarPoses(in, 0, count, positions, rotations);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+
+// converts many double precision pose states to float in one pass
+//
+// input is struct of arrays, the layout of an OSVRPoseTable shard. the SSE2 and AVX2 kernels
+// do the same float operations in the same order as the scalar one, so every path gives
+// the same result. the best kernel the CPU supports is picked at runtime.
+
+struct OSVRPoseColumns
+{
+	const double* translation[3]; // x, y, z
+	const double* rotation[4];    // w, x, y, z like OSVR_Quaternion
+};
+
+namespace OSVRPoseBatch
+{
+	enum Isa {
+		ISA_SCALAR,
+		ISA_SSE2,
+		ISA_AVX2
+	};
+
+	Isa getBestIsa();
+	const char* getIsaName(Isa isa);
+
+	// 16 floats per pose, the layout of ofMatrix4x4 and OSVRMatrix (row-major, row vectors,
+	// translation in 12..14) and the same matrix ofMatrix4x4::setRotate + setTranslation build
+	void toMatrices(const OSVRPoseColumns& in, size_t count, float* matrices);
+	void toMatrices(const OSVRPoseColumns& in, size_t count, float* matrices, Isa isa);
+
+	// 3 floats (x, y, z) and 4 floats (x, y, z, w) per pose, either output may be null
+	void toPoses(const OSVRPoseColumns& in, size_t count, float* positions, float* rotations);
+	void toPoses(const OSVRPoseColumns& in, size_t count, float* positions, float* rotations, Isa isa);
+
+	// 3 floats per vector from x, y, z columns, e.g. the velocity columns of a shard
+	void toVectors(const double* const in[3], size_t count, float* vectors);
+}
@@ -0,0 +1,183 @@
+#include "OSVRPoseCodec.h"
+#include "OSVRQuantize.h"
+
+#include <cmath>
+
+namespace
+{
+	enum {
+		QUAT_BITS = 15,
+		FLAG_KEYFRAME = 1,
+		FLAG_VALID = 2,
+		LARGEST_SHIFT = 2, // the index of the dropped rotation component, 2 bits
+		FLAG_NORM = 16     // followed by the rotation's norm error in millionths
+	};
+
+	const uint64_t QUAT_MASK = (uint64_t(1) << QUAT_BITS) - 1;
+}
+
+OSVRPoseEncoder::OSVRPoseEncoder(double precision, int keyframeInterval)
+	:precision(precision), keyframe_interval(keyframeInterval < 1 ? 1 : keyframeInterval)
+{
+
+}
+
+size_t OSVRPoseEncoder::encode(const OSVRPoseSample& sample, uint8_t* out)
+{
+	if (sample.handle >= OSVRPoseSample::MAX_HANDLES)
+		return 0;
+	if (states.size() <= sample.handle)
+		states.resize(sample.handle + 1);
+	State& state = states[sample.handle];
+
+	int32_t position[3];
+	for (int i = 0; i < 3; i++)
+		position[i] = OSVRQuantize::packPosition(sample.translation[i], precision);
+
+	uint64_t packed = OSVRQuantize::packQuat(sample.rotation, QUAT_BITS);
+	int largest = int(packed >> (3 * QUAT_BITS)) & 3;
+	int32_t rotation[3];
+	for (int i = 0; i < 3; i++)
+		rotation[i] = int32_t((packed >> ((2 - i) * QUAT_BITS)) & QUAT_MASK);
+
+	bool keyframe = state.since_keyframe < 0 || state.since_keyframe >= keyframe_interval;
+
+	// smallest-three only stores unit rotations, a broken norm is kept on the side
+	const float* q = sample.rotation;
+	float norm2 = q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3];
+	int64_t norm_error = 0;
+	// |norm2 - 1| is about twice |norm - 1|, below 0.7e-6 the error rounds to 0 without the sqrt
+	if (std::fabs(norm2 - 1.0f) >= 0.7e-6f)
+		norm_error = OSVRQuantize::roundToInt((std::sqrt(norm2) - 1.0f) * 1e6);
+
+	uint8_t* p = out;
+	*p++ = uint8_t((keyframe ? FLAG_KEYFRAME : 0) | (sample.valid ? FLAG_VALID : 0) | (largest << LARGEST_SHIFT) | (norm_error != 0 ? FLAG_NORM : 0));
+	p = OSVRVarint::put(p, sample.handle);
+	if (keyframe)
+	{
+		p = OSVRVarint::putSigned(p, sample.timestamp);
+		for (int i = 0; i < 3; i++)
+			p = OSVRVarint::putSigned(p, position[i]);
+		for (int i = 0; i < 3; i++)
+			p = OSVRVarint::put(p, uint64_t(rotation[i]));
+		state.since_keyframe = 0;
+	}
+	else
+	{
+		p = OSVRVarint::putSigned(p, sample.timestamp - state.timestamp);
+		for (int i = 0; i < 3; i++)
+			p = OSVRVarint::putSigned(p, int64_t(position[i]) - state.position[i]);
+		for (int i = 0; i < 3; i++)
+			p = OSVRVarint::putSigned(p, int64_t(rotation[i]) - state.rotation[i]);
+	}
+	if (norm_error != 0)
+		p = OSVRVarint::putSigned(p, norm_error);
+	state.since_keyframe++;
+
+	for (int i = 0; i < 3; i++)
+	{
+		state.position[i] = position[i];
+		state.rotation[i] = rotation[i];
+	}
+	state.timestamp = sample.timestamp;
+	return size_t(p - out);
+}
+
+void OSVRPoseEncoder::reset()
+{
+	for (auto& state : states)
+		state.since_keyframe = -1;
+}
+
+OSVRPoseDecoder::OSVRPoseDecoder(double precision)
+	:precision(precision)
+{
+
+}
+
+size_t OSVRPoseDecoder::decode(const uint8_t* data, size_t size, OSVRPoseSample& sample)
+{
+	const uint8_t* end = data + size;
+	const uint8_t* p = data;
+	if (p == end)
+		return 0;
+
+	uint8_t flags = *p++;
+	uint64_t handle;
+	p = OSVRVarint::get(p, end, handle);
+	// the handle sizes the state table, a corrupt stream must not pick it
+	if (p == nullptr || handle >= OSVRPoseSample::MAX_HANDLES)
+		return 0;
+
+	bool keyframe = (flags & FLAG_KEYFRAME) != 0;
+	int64_t timestamp;
+	int64_t position[3];
+	int64_t rotation[3];
+	p = OSVRVarint::getSigned(p, end, timestamp);
+	for (int i = 0; i < 3 && p; i++)
+		p = OSVRVarint::getSigned(p, end, position[i]);
+	for (int i = 0; i < 3 && p; i++)
+	{
+		if (keyframe)
+		{
+			uint64_t u;
+			p = OSVRVarint::get(p, end, u);
+			rotation[i] = int64_t(u);
+		}
+		else
+			p = OSVRVarint::getSigned(p, end, rotation[i]);
+	}
+	int64_t norm_error = 0;
+	if (p && (flags & FLAG_NORM))
+		p = OSVRVarint::getSigned(p, end, norm_error);
+	if (p == nullptr)
+		return 0;
+
+	if (states.size() <= handle)
+		states.resize(size_t(handle) + 1);
+	State& state = states[size_t(handle)];
+
+	if (keyframe)
+		state.has_keyframe = true;
+	else if (state.has_keyframe == false)
+		return 0;
+	else
+	{
+		timestamp += state.timestamp;
+		for (int i = 0; i < 3; i++)
+		{
+			position[i] += state.position[i];
+			rotation[i] += state.rotation[i];
+		}
+	}
+
+	uint64_t packed = uint64_t((flags >> LARGEST_SHIFT) & 3);
+	for (int i = 0; i < 3; i++)
+	{
+		state.position[i] = int32_t(position[i]);
+		state.rotation[i] = int32_t(rotation[i]);
+		packed = (packed << QUAT_BITS) | (uint64_t(rotation[i]) & QUAT_MASK);
+	}
+	state.timestamp = timestamp;
+
+	sample.handle = uint32_t(handle);
+	sample.path = nullptr;
+	for (int i = 0; i < 3; i++)
+		sample.translation[i] = float(OSVRQuantize::unpackPosition(state.position[i], precision));
+	OSVRQuantize::unpackQuat(packed, sample.rotation, QUAT_BITS);
+	if (norm_error != 0)
+	{
+		float norm = 1.0f + float(norm_error) * 1e-6f;
+		for (int i = 0; i < 4; i++)
+			sample.rotation[i] *= norm;
+	}
+	sample.timestamp = timestamp;
+	sample.valid = (flags & FLAG_VALID) != 0;
+	return size_t(p - data);
+}
+
+void OSVRPoseDecoder::reset()
+{
+	for (auto& state : states)
+		state.has_keyframe = false;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// compact coding of pose reports, shared by session recordings and the network
+//
+// a sample is quantized first, rotation as smallest-three and position in units of
+// `precision` metres, then written as zigzag varints of the difference to the previous
+// sample of the same interface. a keyframe stores the values themselves, so decoding
+// can start at any keyframe; the encoder emits one per interface every keyframeInterval
+// samples and after reset(). rotations that aren't unit length keep their norm to 1e-6.
+
+struct OSVRPoseSample
+{
+	enum {
+		MAX_HANDLES = 4096 // the capacity of OSVRPoseTable, larger handles are rejected
+	};
+
+	uint32_t handle;
+	const char* path;  // only carried where the format names interfaces, may be null
+	float translation[3];
+	float rotation[4]; // x, y, z, w
+	int64_t timestamp; // OSVR report time, microseconds
+	bool valid;
+};
+
+namespace OSVRVarint
+{
+	enum { MAX_SIZE = 10 };
+
+	inline uint64_t zigzag(int64_t v) { return (uint64_t(v) << 1) ^ uint64_t(v >> 63); }
+	inline int64_t unzigzag(uint64_t v) { return int64_t(v >> 1) ^ -int64_t(v & 1); }
+
+	inline uint8_t* put(uint8_t* p, uint64_t v)
+	{
+		while (v >= 0x80)
+		{
+			*p++ = uint8_t(v) | 0x80;
+			v >>= 7;
+		}
+		*p++ = uint8_t(v);
+		return p;
+	}
+
+	// nullptr when the value runs past end
+	inline const uint8_t* get(const uint8_t* p, const uint8_t* end, uint64_t& v)
+	{
+		v = 0;
+		for (int shift = 0; p < end && shift < 64; shift += 7)
+		{
+			uint8_t b = *p++;
+			v |= uint64_t(b & 0x7f) << shift;
+			if ((b & 0x80) == 0)
+				return p;
+		}
+		return nullptr;
+	}
+
+	inline uint8_t* putSigned(uint8_t* p, int64_t v) { return put(p, zigzag(v)); }
+
+	inline const uint8_t* getSigned(const uint8_t* p, const uint8_t* end, int64_t& v)
+	{
+		uint64_t u;
+		p = get(p, end, u);
+		v = unzigzag(u);
+		return p;
+	}
+}
+
+class OSVRPoseEncoder
+{
+public:
+	enum {
+		// flags, handle, timestamp, 3 position, 3 rotation and a norm varint
+		MAX_SAMPLE_SIZE = 1 + 9 * OSVRVarint::MAX_SIZE
+	};
+
+	explicit OSVRPoseEncoder(double precision = 0.001, int keyframeInterval = 1000);
+
+	// writes one sample to out, which must hold MAX_SAMPLE_SIZE bytes, returns its size or
+	// 0 for a handle at or above OSVRPoseSample::MAX_HANDLES
+	size_t encode(const OSVRPoseSample& sample, uint8_t* out);
+
+	// the next sample of every interface becomes a keyframe
+	void reset();
+
+	double getPrecision() const { return precision; }
+
+private:
+	struct State
+	{
+		int32_t position[3];
+		int32_t rotation[3];
+		int64_t timestamp;
+		int since_keyframe = -1; // -1 until the first keyframe
+	};
+
+	double precision;
+	int keyframe_interval;
+	std::vector<State> states; // by handle
+};
+
+class OSVRPoseDecoder
+{
+public:
+	explicit OSVRPoseDecoder(double precision = 0.001);
+
+	// reads one sample, returns the bytes consumed or 0 when the data is truncated, names
+	// a handle at or above OSVRPoseSample::MAX_HANDLES or is a delta for an interface
+	// without a keyframe yet. path is left null
+	size_t decode(const uint8_t* data, size_t size, OSVRPoseSample& sample);
+
+	void reset();
+
+	double getPrecision() const { return precision; }
+
+private:
+	struct State
+	{
+		int32_t position[3];
+		int32_t rotation[3];
+		int64_t timestamp;
+		bool has_keyframe = false;
+	};
+
+	double precision;
+	std::vector<State> states; // by handle
+};
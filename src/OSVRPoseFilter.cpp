@@ -0,0 +1,144 @@
+#include "OSVRPoseFilter.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+	const double PI = 3.14159265358979323846;
+
+	// smoothing factor of a first-order low-pass at this cutoff for a step of dt
+	double alpha(double cutoff, double dt)
+	{
+		double tau = 1.0 / (2.0 * PI * cutoff);
+		return 1.0 / (1.0 + tau / dt);
+	}
+
+	double seconds(const OSVR_TimeValue& a, const OSVR_TimeValue& b)
+	{
+		return double(a.seconds - b.seconds) + double(a.microseconds - b.microseconds) * 1e-6;
+	}
+
+	// q = slerp(from, to, t), both unit, w x y z
+	void slerp(const double from[4], const double to[4], double t, double q[4])
+	{
+		double dot = from[0] * to[0] + from[1] * to[1] + from[2] * to[2] + from[3] * to[3];
+		double sign = dot < 0.0 ? -1.0 : 1.0;
+		dot *= sign;
+
+		double a, b;
+		if (dot > 0.9995)
+		{
+			// nearly parallel, nlerp is exact enough and avoids dividing by sin ~ 0
+			a = 1.0 - t;
+			b = t;
+		}
+		else
+		{
+			double theta = std::acos(dot);
+			double s = std::sin(theta);
+			a = std::sin((1.0 - t) * theta) / s;
+			b = std::sin(t * theta) / s;
+		}
+
+		double length = 0.0;
+		for (int i = 0; i < 4; i++)
+		{
+			q[i] = a * from[i] + b * sign * to[i];
+			length += q[i] * q[i];
+		}
+		length = std::sqrt(length);
+		for (int i = 0; i < 4; i++)
+			q[i] /= length;
+	}
+}
+
+void OSVRPoseFilterBank::setParams(uint32_t handle, const OSVRFilterParams& params)
+{
+	if (filters.size() <= handle)
+		filters.resize(handle + 1);
+	Filter& f = filters[handle];
+
+	if (f.params.enabled != params.enabled)
+		enabled_count += params.enabled ? 1 : size_t(-1);
+	if (!params.enabled)
+	{
+		// start over from the raw pose when enabled again
+		f.has_previous = false;
+		f.latency = 0.0;
+	}
+	f.params = params;
+}
+
+void OSVRPoseFilterBank::apply(uint32_t first, uint64_t mask, uint64_t fresh, OSVR_PoseState* states, const OSVR_TimeValue* timestamps)
+{
+	if (enabled_count == 0 || first >= filters.size())
+		return;
+
+	size_t count = std::min<size_t>(64, filters.size() - first);
+	for (size_t i = 0; i < count; i++)
+	{
+		Filter& f = filters[first + i];
+		if ((mask & (uint64_t(1) << i)) == 0 || f.params.enabled == false)
+			continue;
+		if (fresh & (uint64_t(1) << i))
+		{
+			filter(f, states[i], timestamps[i]);
+		}
+		else if (f.has_previous)
+		{
+			std::copy(f.position, f.position + 3, states[i].translation.data);
+			std::copy(f.rotation, f.rotation + 4, states[i].rotation.data);
+		}
+	}
+}
+
+void OSVRPoseFilterBank::filter(Filter& f, OSVR_PoseState& state, const OSVR_TimeValue& timestamp)
+{
+	double* position = state.translation.data;
+	double* rotation = state.rotation.data;
+
+	double dt = f.has_previous ? seconds(timestamp, f.timestamp) : 0.0;
+	if (!f.has_previous || dt <= 0.0 || dt > 1.0)
+	{
+		// first report, or time went backwards or stalled: restart from the raw pose
+		std::copy(position, position + 3, f.position);
+		std::copy(rotation, rotation + 4, f.rotation);
+		std::fill(f.velocity, f.velocity + 3, 0.0);
+		f.angular_speed = 0.0;
+		f.timestamp = timestamp;
+		f.has_previous = true;
+		f.latency = 0.0;
+		return;
+	}
+	f.timestamp = timestamp;
+
+	const OSVRFilterParams& p = f.params;
+	double derivative_alpha = alpha(p.derivative_cutoff, dt);
+
+	// position
+	double speed = 0.0;
+	for (int k = 0; k < 3; k++)
+	{
+		double v = (position[k] - f.position[k]) / dt;
+		f.velocity[k] += derivative_alpha * (v - f.velocity[k]);
+		speed += f.velocity[k] * f.velocity[k];
+	}
+	double cutoff = p.min_cutoff + p.beta * std::sqrt(speed);
+	double a = alpha(cutoff, dt);
+	for (int k = 0; k < 3; k++)
+	{
+		f.position[k] += a * (position[k] - f.position[k]);
+		position[k] = f.position[k];
+	}
+
+	// rotation
+	double dot = std::fabs(f.rotation[0] * rotation[0] + f.rotation[1] * rotation[1] + f.rotation[2] * rotation[2] + f.rotation[3] * rotation[3]);
+	double angular_speed = 2.0 * std::acos(std::min(1.0, dot)) / dt;
+	f.angular_speed += derivative_alpha * (angular_speed - f.angular_speed);
+	double rotation_cutoff = p.rotation_min_cutoff + p.rotation_beta * f.angular_speed;
+	slerp(f.rotation, rotation, alpha(rotation_cutoff, dt), f.rotation);
+	std::copy(f.rotation, f.rotation + 4, rotation);
+
+	f.latency = 1.0 / (2.0 * PI * std::min(cutoff, rotation_cutoff));
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// ignore conflict define
+#pragma push_macro("ignore")
+#undef near
+#undef far
+#include "osvr/ClientKit/InterfaceStateC.h"
+#pragma pop_macro("ignore")
+
+// One-Euro smoothing of pose reports, run per interface on the poll thread
+//
+// a One-Euro filter is a low-pass whose cutoff rises with speed: heavy smoothing kills
+// jitter at rest, and the cutoff opens up as soon as the tracker moves so it doesn't lag.
+// positions are filtered as vectors, rotations by slerping towards each report with the
+// same speed-dependent rate taken from the angular speed. the added latency is the time
+// constant of the current cutoff, 1 / (2 pi cutoff).
+
+struct OSVRFilterParams
+{
+	bool enabled = false;
+
+	// position, cutoff in Hz at rest and its increase per m/s
+	double min_cutoff = 1.0;
+	double beta = 0.5;
+
+	// rotation, cutoff in Hz at rest and its increase per rad/s
+	double rotation_min_cutoff = 1.0;
+	double rotation_beta = 0.3;
+
+	// cutoff of the speed estimate itself
+	double derivative_cutoff = 1.0;
+};
+
+class OSVRPoseFilterBank
+{
+public:
+	// grows only when a new handle gets parameters
+	void setParams(uint32_t handle, const OSVRFilterParams& params);
+
+	// filters states[i] for every bit i in fresh in place, slot i is handle first + i. other
+	// bits in mask repeat a report already filtered and get the last filtered pose back
+	void apply(uint32_t first, uint64_t mask, uint64_t fresh, OSVR_PoseState* states, const OSVR_TimeValue* timestamps);
+
+	// seconds the filtered pose currently trails the reports, 0 when not filtered
+	double getLatency(uint32_t handle) const
+	{
+		return handle < filters.size() && filters[handle].params.enabled ? filters[handle].latency : 0.0;
+	}
+
+	bool isActive() const { return enabled_count > 0; }
+
+private:
+	struct Filter
+	{
+		OSVRFilterParams params;
+		bool has_previous = false;
+		OSVR_TimeValue timestamp;
+		double position[3];
+		double velocity[3];
+		double rotation[4]; // w, x, y, z
+		double angular_speed;
+		double latency = 0.0;
+	};
+
+	void filter(Filter& f, OSVR_PoseState& state, const OSVR_TimeValue& timestamp);
+
+	std::vector<Filter> filters; // by handle
+	size_t enabled_count = 0;
+};
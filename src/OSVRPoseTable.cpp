@@ -0,0 +1,210 @@
+#include "OSVRPoseTable.h"
+
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+	bool isNewer(const OSVR_TimeValue& a, const OSVR_TimeValue& b)
+	{
+		return a.seconds != b.seconds ? a.seconds > b.seconds : a.microseconds > b.microseconds;
+	}
+
+	bool isSameTime(const OSVR_TimeValue& a, const OSVR_TimeValue& b)
+	{
+		return a.seconds == b.seconds && a.microseconds == b.microseconds;
+	}
+
+	// axis times angle / dt of an incremental rotation, w x y z
+	void toRate(const OSVR_IncrementalQuaternion& q, double dt, double rate[3])
+	{
+		double w = q.data[0];
+		double sign = w < 0.0 ? -1.0 : 1.0; // the short way round
+		double length = sqrt(q.data[1] * q.data[1] + q.data[2] * q.data[2] + q.data[3] * q.data[3]);
+		double scale = length > 1e-12 && dt > 0.0 ? 2.0 * atan2(length, w * sign) / (length * dt) * sign : 0.0;
+		for (int k = 0; k < 3; k++)
+			rate[k] = q.data[k + 1] * scale;
+	}
+
+	// derivative reports of iface, true when any is newer than what the shard holds
+	bool queryDerivatives(OSVR_ClientInterface iface, const OSVRPoseTable::Shard& shard, uint32_t i, OSVRPoseDerivatives& d)
+	{
+		d.flags = 0;
+		fill(d.linear_velocity, d.linear_velocity + 3, 0.0);
+		fill(d.angular_velocity, d.angular_velocity + 3, 0.0);
+		fill(d.linear_acceleration, d.linear_acceleration + 3, 0.0);
+		fill(d.angular_acceleration, d.angular_acceleration + 3, 0.0);
+		d.velocity_timestamp = d.acceleration_timestamp = OSVR_TimeValue{ 0, 0 };
+		bool fresh = false;
+
+		OSVR_VelocityState velocity;
+		if (osvrGetVelocityState(iface, &d.velocity_timestamp, &velocity) == OSVR_RETURN_SUCCESS)
+		{
+			if (velocity.linearVelocityValid)
+			{
+				d.flags |= OSVRPoseDerivatives::LINEAR_VELOCITY;
+				copy(velocity.linearVelocity.data, velocity.linearVelocity.data + 3, d.linear_velocity);
+			}
+			if (velocity.angularVelocityValid)
+			{
+				d.flags |= OSVRPoseDerivatives::ANGULAR_VELOCITY;
+				toRate(velocity.angularVelocity.incrementalRotation, velocity.angularVelocity.dt, d.angular_velocity);
+			}
+			fresh |= isSameTime(d.velocity_timestamp, shard.velocity_timestamp[i]) == false;
+		}
+
+		OSVR_AccelerationState acceleration;
+		if (osvrGetAccelerationState(iface, &d.acceleration_timestamp, &acceleration) == OSVR_RETURN_SUCCESS)
+		{
+			if (acceleration.linearAccelerationValid)
+			{
+				d.flags |= OSVRPoseDerivatives::LINEAR_ACCELERATION;
+				copy(acceleration.linearAcceleration.data, acceleration.linearAcceleration.data + 3, d.linear_acceleration);
+			}
+			if (acceleration.angularAccelerationValid)
+			{
+				d.flags |= OSVRPoseDerivatives::ANGULAR_ACCELERATION;
+				toRate(acceleration.angularAcceleration.incrementalRotation, acceleration.angularAcceleration.dt, d.angular_acceleration);
+			}
+			fresh |= isSameTime(d.acceleration_timestamp, shard.acceleration_timestamp[i]) == false;
+		}
+		return fresh;
+	}
+}
+
+OSVRPoseTable::~OSVRPoseTable()
+{
+	for (auto& s : shards)
+		delete s.load(memory_order_relaxed);
+}
+
+bool OSVRPoseTable::insert(uint32_t handle, OSVR_ClientInterface iface)
+{
+	if (handle >= CAPACITY)
+		return false;
+
+	Shard* shard = shards[handle / SHARD_SIZE].load(memory_order_relaxed);
+	if (shard == nullptr)
+	{
+		shard = new Shard();
+		memset(shard->translation, 0, sizeof(shard->translation));
+		memset(shard->rotation, 0, sizeof(shard->rotation));
+		memset(shard->timestamp, 0, sizeof(shard->timestamp));
+		memset(shard->interfaces, 0, sizeof(shard->interfaces));
+		memset(shard->derivative_flags, 0, sizeof(shard->derivative_flags));
+		memset(shard->linear_velocity, 0, sizeof(shard->linear_velocity));
+		memset(shard->angular_velocity, 0, sizeof(shard->angular_velocity));
+		memset(shard->linear_acceleration, 0, sizeof(shard->linear_acceleration));
+		memset(shard->angular_acceleration, 0, sizeof(shard->angular_acceleration));
+		memset(shard->velocity_timestamp, 0, sizeof(shard->velocity_timestamp));
+		memset(shard->acceleration_timestamp, 0, sizeof(shard->acceleration_timestamp));
+		for (auto& h : shard->has_state)
+			h = true;
+		for (int i = 0; i < SHARD_SIZE; i++)
+		{
+			shard->rotation[0][i] = 1.0; // identity until the first report
+			shard->generation[i].store(0, memory_order_relaxed);
+		}
+		shards[handle / SHARD_SIZE].store(shard, memory_order_release);
+	}
+
+	uint32_t i = handle % SHARD_SIZE;
+	shard->interfaces[i] = iface;
+	shard->present.fetch_or(uint64_t(1) << i, memory_order_release);
+	return true;
+}
+
+bool OSVRPoseTable::poll(OSVR_TimeValue& newest, vector<uint32_t>& lost, Stage* stage, bool rewrite)
+{
+	lost.clear();
+	bool fresh = false;
+
+	OSVR_PoseState states[SHARD_SIZE];
+	OSVR_TimeValue timestamps[SHARD_SIZE];
+	OSVRPoseDerivatives derivatives[SHARD_SIZE];
+
+	for (uint32_t s = 0; s < MAX_SHARDS; s++)
+	{
+		Shard* shard = shards[s].load(memory_order_relaxed);
+		if (shard == nullptr)
+			continue;
+
+		// query outside the write window, readers only retry while the columns are copied
+		uint64_t present = shard->present.load(memory_order_relaxed);
+		uint64_t updated = 0;
+		uint64_t updated_fresh = 0;
+		for (uint32_t i = 0; i < SHARD_SIZE; i++)
+		{
+			if ((present & (uint64_t(1) << i)) == 0)
+				continue;
+			if (osvrGetPoseState(shard->interfaces[i], &timestamps[i], &states[i]) != OSVR_RETURN_SUCCESS)
+			{
+				// report once per interface, not once per tick
+				if (shard->has_state[i])
+					lost.push_back(s * SHARD_SIZE + i);
+				shard->has_state[i] = false;
+			}
+			else
+			{
+				bool new_pose = isSameTime(timestamps[i], shard->timestamp[i]) == false;
+				bool new_derivatives = queryDerivatives(shard->interfaces[i], *shard, i, derivatives[i]);
+				if (new_pose)
+				{
+					if (!fresh || isNewer(timestamps[i], newest))
+						newest = timestamps[i];
+					fresh = true;
+					shard->has_state[i] = true;
+					updated_fresh |= uint64_t(1) << i;
+				}
+				// derivatives can change without a new pose, e.g. from an IMU running faster
+				if (new_pose || new_derivatives || (rewrite && shard->has_state[i]))
+					updated |= uint64_t(1) << i;
+			}
+		}
+		if (updated == 0)
+			continue;
+
+		if (stage)
+			stage->process(s * SHARD_SIZE, updated, updated_fresh, states, derivatives, timestamps);
+
+		shard->seq.store(shard->seq.load(memory_order_relaxed) + 1, memory_order_relaxed);
+		atomic_thread_fence(memory_order_release);
+		for (uint32_t i = 0; i < SHARD_SIZE; i++)
+		{
+			if ((updated & (uint64_t(1) << i)) == 0)
+				continue;
+			for (int k = 0; k < 3; k++)
+				shard->translation[k][i] = states[i].translation.data[k];
+			for (int k = 0; k < 4; k++)
+				shard->rotation[k][i] = states[i].rotation.data[k];
+			shard->timestamp[i] = timestamps[i];
+
+			const OSVRPoseDerivatives& d = derivatives[i];
+			shard->derivative_flags[i] = d.flags;
+			for (int k = 0; k < 3; k++)
+			{
+				shard->linear_velocity[k][i] = d.linear_velocity[k];
+				shard->angular_velocity[k][i] = d.angular_velocity[k];
+				shard->linear_acceleration[k][i] = d.linear_acceleration[k];
+				shard->angular_acceleration[k][i] = d.angular_acceleration[k];
+			}
+			shard->velocity_timestamp[i] = d.velocity_timestamp;
+			shard->acceleration_timestamp[i] = d.acceleration_timestamp;
+		}
+		shard->seq.store(shard->seq.load(memory_order_relaxed) + 1, memory_order_release);
+
+		// sequentially consistent, pairs with the waiter count of whoever waits on it
+		for (uint32_t i = 0; i < SHARD_SIZE; i++)
+		{
+			if (updated_fresh & (uint64_t(1) << i))
+				shard->generation[i].fetch_add(1);
+		}
+
+		if (stage && updated_fresh)
+			stage->published(s * SHARD_SIZE, updated_fresh, states, timestamps);
+	}
+	return fresh;
+}
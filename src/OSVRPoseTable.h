@@ -0,0 +1,186 @@
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <vector>
+#include <thread>
+#include <cstdint>
+
+// ignore conflict define
+#pragma push_macro("ignore")
+#undef near
+#undef far
+#include "osvr/ClientKit/InterfaceStateC.h"
+#pragma pop_macro("ignore")
+
+// velocity and acceleration reports of an interface, from trackers with an IMU. angular
+// rates are axis times radians per second (per second squared), converted from OSVR's
+// incremental rotations. all in the space of the pose
+struct OSVRPoseDerivatives
+{
+	enum {
+		LINEAR_VELOCITY = 1,
+		ANGULAR_VELOCITY = 2,
+		LINEAR_ACCELERATION = 4,
+		ANGULAR_ACCELERATION = 8
+	};
+
+	uint32_t flags = 0; // which of the vectors below were reported
+	double linear_velocity[3];
+	double angular_velocity[3];
+	double linear_acceleration[3];
+	double angular_acceleration[3];
+	OSVR_TimeValue velocity_timestamp;
+	OSVR_TimeValue acceleration_timestamp;
+};
+
+// the latest pose state of every interface, written by the poll thread, read lock-free
+//
+// handles are grouped into shards of SHARD_SIZE. a shard keeps each field in its own
+// column (struct of arrays) and has its own sequence counter, so a poll only makes
+// readers of the shard being copied retry, and reading one interface touches a few cache
+// lines instead of a tree node per interface. shards are allocated on first use and never
+// move or go away while the table lives.
+
+class OSVRPoseTable
+{
+public:
+	enum {
+		SHARD_SIZE = 64,
+		MAX_SHARDS = 64,
+		CAPACITY = SHARD_SIZE * MAX_SHARDS
+	};
+
+	struct Shard
+	{
+		std::atomic<uint32_t> seq{ 0 };
+		std::atomic<uint64_t> present{ 0 }; // bit i set once slot i is inserted
+		std::atomic<uint64_t> generation[SHARD_SIZE]; // fresh reports so far, bumped after publishing
+
+		// published columns, guarded by seq
+		double translation[3][SHARD_SIZE];
+		double rotation[4][SHARD_SIZE]; // w, x, y, z like OSVR_Quaternion
+		OSVR_TimeValue timestamp[SHARD_SIZE];
+		uint32_t derivative_flags[SHARD_SIZE]; // OSVRPoseDerivatives flags
+		double linear_velocity[3][SHARD_SIZE];
+		double angular_velocity[3][SHARD_SIZE];
+		double linear_acceleration[3][SHARD_SIZE];
+		double angular_acceleration[3][SHARD_SIZE];
+		OSVR_TimeValue velocity_timestamp[SHARD_SIZE];
+		OSVR_TimeValue acceleration_timestamp[SHARD_SIZE];
+
+		// poll thread only
+		OSVR_ClientInterface interfaces[SHARD_SIZE];
+		bool has_state[SHARD_SIZE];
+	};
+
+	// runs between polling and publishing, e.g. filtering. states, derivatives and
+	// timestamps hold the slots of one shard, handle first + i. bits in mask are about to be
+	// written, bits in fresh (a subset) carry a new pose report, the others repeat the last
+	// pose, possibly with new derivatives
+	class Stage
+	{
+	public:
+		virtual ~Stage() {}
+		virtual void process(uint32_t first, uint64_t mask, uint64_t fresh, OSVR_PoseState* states, OSVRPoseDerivatives* derivatives, const OSVR_TimeValue* timestamps) = 0;
+		// after the fresh slots were published, readers already see them
+		virtual void published(uint32_t first, uint64_t fresh, const OSVR_PoseState* states, const OSVR_TimeValue* timestamps) {}
+	};
+
+	OSVRPoseTable() { for (auto& s : shards) s.store(nullptr, std::memory_order_relaxed); }
+	~OSVRPoseTable();
+
+	OSVRPoseTable(const OSVRPoseTable&) = delete;
+	OSVRPoseTable& operator=(const OSVRPoseTable&) = delete;
+
+	// poll thread. false beyond CAPACITY
+	bool insert(uint32_t handle, OSVR_ClientInterface iface);
+
+	// poll thread. reads every interface's pose state and publishes the fresh ones shard by
+	// shard, after running them through stage if given. rewrite publishes repeated reports
+	// too, when the stage changed what it does to them. newest is the latest fresh report
+	// time, for the clock mapper; lost collects handles whose state just went away. false
+	// when no report was fresh
+	bool poll(OSVR_TimeValue& newest, std::vector<uint32_t>& lost, Stage* stage = nullptr, bool rewrite = false);
+
+	// any thread, false until the handle was inserted
+	bool read(uint32_t handle, OSVR_PoseState& state, OSVR_TimeValue& timestamp) const
+	{
+		const Shard* shard = handle < CAPACITY ? shards[handle / SHARD_SIZE].load(std::memory_order_acquire) : nullptr;
+		if (shard == nullptr)
+			return false;
+		uint32_t i = handle % SHARD_SIZE;
+		if ((shard->present.load(std::memory_order_acquire) & (uint64_t(1) << i)) == 0)
+			return false;
+
+		for (;;)
+		{
+			uint32_t begin = shard->seq.load(std::memory_order_acquire);
+			if (begin & 1)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			for (int k = 0; k < 3; k++)
+				state.translation.data[k] = shard->translation[k][i];
+			for (int k = 0; k < 4; k++)
+				state.rotation.data[k] = shard->rotation[k][i];
+			timestamp = shard->timestamp[i];
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (shard->seq.load(std::memory_order_relaxed) == begin)
+				return true;
+		}
+	}
+
+	// any thread, false until the handle was inserted. flags are 0 for an interface without
+	// velocity or acceleration reports
+	bool readDerivatives(uint32_t handle, OSVRPoseDerivatives& derivatives) const
+	{
+		const Shard* shard = getShard(handle);
+		if (shard == nullptr)
+			return false;
+		uint32_t i = handle % SHARD_SIZE;
+		if ((shard->present.load(std::memory_order_acquire) & (uint64_t(1) << i)) == 0)
+			return false;
+
+		for (;;)
+		{
+			uint32_t begin = shard->seq.load(std::memory_order_acquire);
+			if (begin & 1)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			derivatives.flags = shard->derivative_flags[i];
+			for (int k = 0; k < 3; k++)
+			{
+				derivatives.linear_velocity[k] = shard->linear_velocity[k][i];
+				derivatives.angular_velocity[k] = shard->angular_velocity[k][i];
+				derivatives.linear_acceleration[k] = shard->linear_acceleration[k][i];
+				derivatives.angular_acceleration[k] = shard->angular_acceleration[k][i];
+			}
+			derivatives.velocity_timestamp = shard->velocity_timestamp[i];
+			derivatives.acceleration_timestamp = shard->acceleration_timestamp[i];
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (shard->seq.load(std::memory_order_relaxed) == begin)
+				return true;
+		}
+	}
+
+	// any thread, number of fresh reports published for handle, 0 before the first
+	uint64_t getGeneration(uint32_t handle) const
+	{
+		const Shard* shard = getShard(handle);
+		// sequentially consistent, see poll()
+		return shard ? shard->generation[handle % SHARD_SIZE].load() : 0;
+	}
+
+	// shard holding handle, nullptr before its first insert
+	const Shard* getShard(uint32_t handle) const
+	{
+		return handle < CAPACITY ? shards[handle / SHARD_SIZE].load(std::memory_order_acquire) : nullptr;
+	}
+
+private:
+	std::array<std::atomic<Shard*>, MAX_SHARDS> shards;
+};
@@ -0,0 +1,41 @@
+#include "OSVRPrediction.h"
+
+#include <cmath>
+
+void OSVRPrediction::extrapolate(const OSVR_PoseState& pose, const OSVRPoseDerivatives& d, double dt, OSVR_PoseState& out)
+{
+	typedef OSVRPoseDerivatives D;
+	OSVR_PoseState result = pose;
+
+	for (int k = 0; k < 3; k++)
+	{
+		double v = d.flags & D::LINEAR_VELOCITY ? d.linear_velocity[k] : 0.0;
+		double a = d.flags & D::LINEAR_ACCELERATION ? d.linear_acceleration[k] : 0.0;
+		result.translation.data[k] += (v + 0.5 * a * dt) * dt;
+	}
+
+	if (d.flags & D::ANGULAR_VELOCITY)
+	{
+		// rotation vector over dt, applied on the left like the pose's own frame of reference
+		double theta[3];
+		for (int k = 0; k < 3; k++)
+		{
+			double alpha = d.flags & D::ANGULAR_ACCELERATION ? d.angular_acceleration[k] : 0.0;
+			theta[k] = (d.angular_velocity[k] + 0.5 * alpha * dt) * dt;
+		}
+		double angle = std::sqrt(theta[0] * theta[0] + theta[1] * theta[1] + theta[2] * theta[2]);
+		if (angle > 1e-12)
+		{
+			double s = std::sin(0.5 * angle) / angle;
+			double dq[4] = { std::cos(0.5 * angle), theta[0] * s, theta[1] * s, theta[2] * s };
+			const double* q = pose.rotation.data;
+			double* r = result.rotation.data;
+			r[0] = dq[0] * q[0] - dq[1] * q[1] - dq[2] * q[2] - dq[3] * q[3];
+			r[1] = dq[0] * q[1] + dq[1] * q[0] + dq[2] * q[3] - dq[3] * q[2];
+			r[2] = dq[0] * q[2] - dq[1] * q[3] + dq[2] * q[0] + dq[3] * q[1];
+			r[3] = dq[0] * q[3] + dq[1] * q[2] - dq[2] * q[1] + dq[3] * q[0];
+		}
+	}
+
+	out = result;
+}
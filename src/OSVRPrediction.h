@@ -0,0 +1,14 @@
+#pragma once
+
+#include "OSVRPoseTable.h"
+
+// pose extrapolation from reported velocity and acceleration
+//
+// constant acceleration where the tracker reports it, constant velocity otherwise, and no
+// motion for an interface without velocity reports. differencing poses instead would
+// amplify their jitter, trackers with an IMU measure the rates directly.
+namespace OSVRPrediction
+{
+	// out = pose dt seconds later, out may be pose
+	void extrapolate(const OSVR_PoseState& pose, const OSVRPoseDerivatives& derivatives, double dt, OSVR_PoseState& out);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+// fixed-point packing of poses for recordings and the network
+//
+// rotations use "smallest three": a unit quaternion's largest component is implied by
+// the other three, which then all lie in [-1/sqrt(2), 1/sqrt(2)]. the index of the dropped
+// component takes 2 bits, each kept one `bits` bits. q and -q are the same rotation, so
+// the dropped component is made positive first.
+
+namespace OSVRQuantize
+{
+	const float QUAT_RANGE = 0.70710678118654752f; // 1 / sqrt(2)
+
+	// round half away from zero, inline unlike std::lround
+	inline int64_t roundToInt(double v)
+	{
+		return v >= 0.0 ? int64_t(v + 0.5) : -int64_t(0.5 - v);
+	}
+
+	// the components kept for each dropped one, in index order
+	const int SMALLEST_THREE[4][3] = { { 1, 2, 3 }, { 0, 2, 3 }, { 0, 1, 3 }, { 0, 1, 2 } };
+
+	// rotation as x, y, z, w
+	inline uint64_t packQuat(const float q[4], int bits = 15)
+	{
+		int largest = 0;
+		for (int i = 1; i < 4; i++)
+		{
+			if (std::fabs(q[i]) > std::fabs(q[largest]))
+				largest = i;
+		}
+		float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+
+		const float max_value = float((uint64_t(1) << bits) - 1);
+		uint64_t packed = uint64_t(largest);
+		for (int k = 0; k < 3; k++)
+		{
+			float v = std::max(-QUAT_RANGE, std::min(QUAT_RANGE, q[SMALLEST_THREE[largest][k]] * sign));
+			// never negative, rounding is adding a half and truncating
+			packed = (packed << bits) | uint64_t(int64_t(double((v * (0.5f / QUAT_RANGE) + 0.5f) * max_value) + 0.5));
+		}
+		return packed;
+	}
+
+	inline void unpackQuat(uint64_t packed, float q[4], int bits = 15)
+	{
+		const uint64_t mask = (uint64_t(1) << bits) - 1;
+		const float scale = 2.0f * QUAT_RANGE / float(mask);
+		int largest = int(packed >> (3 * bits)) & 3;
+
+		float sum = 0.0f;
+		for (int k = 0; k < 3; k++)
+		{
+			float v = float(int32_t((packed >> ((2 - k) * bits)) & mask)) * scale - QUAT_RANGE;
+			q[SMALLEST_THREE[largest][k]] = v;
+			sum += v * v;
+		}
+		q[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+	}
+
+	// position in units of `precision` metres
+	inline int32_t packPosition(double meters, double precision)
+	{
+		return int32_t(roundToInt(meters / precision));
+	}
+
+	inline double unpackPosition(int32_t value, double precision)
+	{
+		return value * precision;
+	}
+
+	// OSVR time value as whole microseconds
+	inline int64_t toMicroseconds(int64_t seconds, int32_t microseconds)
+	{
+		return seconds * 1000000 + microseconds;
+	}
+}
@@ -0,0 +1,383 @@
+#include "OSVRSession.h"
+#include "OSVRLog.h"
+
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+
+using namespace std;
+
+namespace
+{
+	const char* module = "OSVR";
+
+	enum {
+		MAGIC = 0x5345534f, // "OSES"
+		VERSION = 1,
+		CHUNK_INTERFACE = 1,
+		CHUNK_BLOCK = 2,
+		BLOCK_HEADER_SIZE = 8 + 8 + 4,
+		BLOCK_BYTES = 64 * 1024,
+		BLOCK_MICROSECONDS = 1000000
+	};
+
+	void putLE(ostream& out, uint64_t v, int n)
+	{
+		char bytes[8];
+		for (int i = 0; i < n; i++)
+			bytes[i] = char(v >> (8 * i));
+		out.write(bytes, n);
+	}
+
+	bool getLE(istream& in, uint64_t& v, int n)
+	{
+		unsigned char bytes[8];
+		if (!in.read((char*)bytes, n))
+			return false;
+		v = 0;
+		for (int i = 0; i < n; i++)
+			v |= uint64_t(bytes[i]) << (8 * i);
+		return true;
+	}
+
+	uint64_t doubleBits(double d) { uint64_t u; memcpy(&u, &d, sizeof(u)); return u; }
+	double bitsDouble(uint64_t u) { double d; memcpy(&d, &u, sizeof(d)); return d; }
+}
+
+bool OSVRSessionWriter::open(const string& path, double precision)
+{
+	close();
+	file.open(path, ios::binary | ios::trunc);
+	if (!file.is_open())
+	{
+		OSVRLog::error(module, "could not create session file: %s", path.c_str());
+		return false;
+	}
+
+	putLE(file, MAGIC, 4);
+	putLE(file, VERSION, 4);
+	putLE(file, doubleBits(precision), 8);
+
+	encoder = OSVRPoseEncoder(precision);
+	block.clear();
+	block.reserve(BLOCK_BYTES + OSVRPoseEncoder::MAX_SAMPLE_SIZE);
+	block_samples = 0;
+	queue.resize(QUEUE_SIZE);
+	queue_begin = 0;
+	queue_count = 0;
+	dropped = 0;
+
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		is_thread_running = true;
+		is_open = true;
+	}
+	thd = std::thread(&OSVRSessionWriter::threadFunction, this);
+	OSVRLog::notice(module, "recording session: %s", path.c_str());
+	return true;
+}
+
+void OSVRSessionWriter::close()
+{
+	if (!thd.joinable())
+		return;
+	{
+		std::lock_guard<std::mutex> guard(mtx);
+		is_open = false;
+		is_thread_running = false;
+	}
+	cv.notify_one();
+	thd.join();
+
+	flushBlock();
+	file.close();
+	names.clear();
+	if (dropped > 0)
+		OSVRLog::warning(module, "dropped %llu pose reports, the disk did not keep up", (unsigned long long)dropped);
+}
+
+void OSVRSessionWriter::addInterface(uint32_t handle, const string& path)
+{
+	std::lock_guard<std::mutex> guard(mtx);
+	if (is_open)
+		names.emplace_back(handle, path);
+}
+
+void OSVRSessionWriter::write(const OSVRPoseSample& sample)
+{
+	if (!is_open)
+		return;
+
+	std::lock_guard<std::mutex> guard(mtx);
+	if (!is_open)
+		return;
+	if (queue_count == QUEUE_SIZE)
+	{
+		dropped++;
+		return;
+	}
+	queue[(queue_begin + queue_count) % QUEUE_SIZE] = sample;
+	// wake the writer once a batch is worth a write, it also wakes on its own
+	if (++queue_count == QUEUE_SIZE / 4)
+		cv.notify_one();
+}
+
+void OSVRSessionWriter::threadFunction()
+{
+	vector<OSVRPoseSample> samples;
+	samples.reserve(QUEUE_SIZE);
+	vector<pair<uint32_t, string>> pending;
+
+	std::unique_lock<std::mutex> guard(mtx);
+	for (;;)
+	{
+		cv.wait_for(guard, std::chrono::milliseconds(100), [&] { return !is_thread_running || queue_count >= QUEUE_SIZE / 4; });
+		bool running = is_thread_running;
+
+		// take everything queued so far and write it outside the lock
+		samples.clear();
+		for (size_t i = 0; i < queue_count; i++)
+			samples.push_back(queue[(queue_begin + i) % QUEUE_SIZE]);
+		queue_begin = (queue_begin + queue_count) % QUEUE_SIZE;
+		queue_count = 0;
+		pending.swap(names);
+
+		guard.unlock();
+		writePending(samples, pending);
+		guard.lock();
+
+		if (!running)
+			break;
+	}
+}
+
+void OSVRSessionWriter::writePending(vector<OSVRPoseSample>& samples, vector<pair<uint32_t, string>>& pending)
+{
+	// interface chunks go first, every chunk is indexed before a reader decodes
+	for (const auto& name : pending)
+	{
+		putLE(file, CHUNK_INTERFACE, 1);
+		putLE(file, 4 + name.second.size(), 4);
+		putLE(file, name.first, 4);
+		file.write(name.second.data(), name.second.size());
+	}
+	pending.clear();
+
+	for (const OSVRPoseSample& sample : samples)
+		encode(sample);
+}
+
+void OSVRSessionWriter::encode(const OSVRPoseSample& sample)
+{
+	if (block_samples == 0)
+		block_begin = sample.timestamp;
+	else if (block.size() >= BLOCK_BYTES || sample.timestamp - block_begin >= BLOCK_MICROSECONDS)
+	{
+		flushBlock();
+		block_begin = sample.timestamp;
+	}
+
+	size_t size = block.size();
+	block.resize(size + OSVRPoseEncoder::MAX_SAMPLE_SIZE);
+	size_t used = encoder.encode(sample, &block[size]);
+	block.resize(size + used);
+	if (used == 0)
+		return;
+	block_end = block_samples == 0 ? sample.timestamp : std::max(block_end, sample.timestamp);
+	block_samples++;
+}
+
+void OSVRSessionWriter::flushBlock()
+{
+	if (block_samples == 0)
+		return;
+
+	putLE(file, CHUNK_BLOCK, 1);
+	putLE(file, BLOCK_HEADER_SIZE + block.size(), 4);
+	putLE(file, uint64_t(block_begin), 8);
+	putLE(file, uint64_t(block_end), 8);
+	putLE(file, block_samples, 4);
+	file.write((const char*)block.data(), block.size());
+
+	// the next block decodes on its own
+	encoder.reset();
+	block.clear();
+	block_samples = 0;
+}
+
+bool OSVRSessionReader::open(const string& path)
+{
+	close();
+	file.open(path, ios::binary);
+	if (!file.is_open())
+	{
+		OSVRLog::error(module, "could not open session file: %s", path.c_str());
+		return false;
+	}
+
+	uint64_t magic, version, bits;
+	if (!getLE(file, magic, 4) || !getLE(file, version, 4) || !getLE(file, bits, 8) || magic != MAGIC || version != VERSION)
+	{
+		OSVRLog::error(module, "not a session file: %s", path.c_str());
+		file.close();
+		return false;
+	}
+	precision = bitsDouble(bits);
+
+	uint64_t header_end = uint64_t(file.tellg());
+	file.seekg(0, ios::end);
+	uint64_t file_size = uint64_t(file.tellg());
+	file.seekg(std::streamoff(header_end));
+
+	// sizes and handles come from the file, nothing is allocated before they were checked
+	// against what the file can hold
+	uint64_t type, size;
+	while (getLE(file, type, 1) && getLE(file, size, 4))
+	{
+		uint64_t chunk_begin = uint64_t(file.tellg());
+		// a truncated or malformed chunk ends the session
+		if (size > file_size - chunk_begin || (type == CHUNK_INTERFACE && size < 4) || (type == CHUNK_BLOCK && size < BLOCK_HEADER_SIZE))
+		{
+			OSVRLog::warning(module, "corrupt session chunk at %llu, ignoring the rest", (unsigned long long)chunk_begin);
+			break;
+		}
+		if (type == CHUNK_INTERFACE)
+		{
+			uint64_t handle;
+			if (!getLE(file, handle, 4))
+				break;
+			if (handle >= OSVRPoseSample::MAX_HANDLES)
+			{
+				OSVRLog::warning(module, "session names handle %llu, skipping it", (unsigned long long)handle);
+			}
+			else
+			{
+				string name(size_t(size - 4), '\0');
+				if (!file.read(&name[0], name.size()))
+					break;
+				if (interfaces.size() <= handle)
+					interfaces.resize(size_t(handle) + 1);
+				interfaces[size_t(handle)] = name;
+			}
+		}
+		else if (type == CHUNK_BLOCK)
+		{
+			uint64_t begin, end, samples;
+			if (!getLE(file, begin, 8) || !getLE(file, end, 8) || !getLE(file, samples, 4))
+				break;
+			// every sample takes at least a byte, readBlock reserves this many
+			if (samples > size - BLOCK_HEADER_SIZE)
+			{
+				OSVRLog::warning(module, "corrupt session chunk at %llu, ignoring the rest", (unsigned long long)chunk_begin);
+				break;
+			}
+			Block b;
+			b.offset = chunk_begin + BLOCK_HEADER_SIZE;
+			b.size = uint32_t(size - BLOCK_HEADER_SIZE);
+			b.samples = uint32_t(samples);
+			b.begin = int64_t(begin);
+			b.end = int64_t(end);
+			blocks.push_back(b);
+		}
+		// unknown chunks are skipped
+		file.seekg(std::streamoff(chunk_begin + size));
+		if (!file)
+			break;
+	}
+	file.clear();
+
+	decoder = OSVRPoseDecoder(precision);
+	has_block = false;
+	block_index = 0;
+	position = 0;
+	return true;
+}
+
+void OSVRSessionReader::close()
+{
+	if (file.is_open())
+		file.close();
+	interfaces.clear();
+	blocks.clear();
+	has_block = false;
+}
+
+bool OSVRSessionReader::seek(int64_t timestamp)
+{
+	// the last block starting at or before timestamp
+	auto it = std::upper_bound(blocks.begin(), blocks.end(), timestamp, [](int64_t t, const Block& b) { return t < b.begin; });
+	block_index = it == blocks.begin() ? 0 : size_t(it - blocks.begin()) - 1;
+	has_block = false;
+	return block_index < blocks.size();
+}
+
+bool OSVRSessionReader::next(OSVRPoseSample& sample)
+{
+	for (;;)
+	{
+		if (!has_block)
+		{
+			if (block_index >= blocks.size() || !loadBlock(block_index, data))
+				return false;
+			decoder.reset();
+			position = 0;
+			has_block = true;
+		}
+
+		if (position < data.size())
+		{
+			size_t used = decoder.decode(&data[position], data.size() - position, sample);
+			if (used != 0)
+			{
+				position += used;
+				sample.path = pathOf(sample.handle);
+				return true;
+			}
+			OSVRLog::warning(module, "corrupt session block %u", unsigned(block_index));
+		}
+
+		has_block = false;
+		block_index++;
+	}
+}
+
+bool OSVRSessionReader::readBlock(size_t index, vector<OSVRPoseSample>& out)
+{
+	out.clear();
+	vector<uint8_t> bytes;
+	if (!loadBlock(index, bytes))
+		return false;
+
+	OSVRPoseDecoder block_decoder(precision);
+	out.reserve(blocks[index].samples);
+	size_t offset = 0;
+	while (offset < bytes.size())
+	{
+		OSVRPoseSample sample;
+		size_t used = block_decoder.decode(&bytes[offset], bytes.size() - offset, sample);
+		if (used == 0)
+			return false;
+		offset += used;
+		sample.path = pathOf(sample.handle);
+		out.push_back(sample);
+	}
+	return true;
+}
+
+bool OSVRSessionReader::loadBlock(size_t index, vector<uint8_t>& bytes)
+{
+	if (index >= blocks.size())
+		return false;
+	const Block& b = blocks[index];
+	bytes.resize(b.size);
+
+	std::lock_guard<std::mutex> guard(mtx);
+	file.clear();
+	file.seekg(std::streamoff(b.offset));
+	return bool(file.read((char*)bytes.data(), b.size));
+}
+
+const char* OSVRSessionReader::pathOf(uint32_t handle) const
+{
+	return handle < interfaces.size() ? interfaces[handle].c_str() : nullptr;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <utility>
+#include <cstdint>
+
+#include "OSVRPoseCodec.h"
+
+// recorded tracking sessions
+//
+// a session file is a header followed by chunks. interface chunks name a handle, block
+// chunks hold the pose reports of about a second, coded with OSVRPoseEncoder. every block
+// starts with keyframes, so a reader can seek to and decode any block on its own.
+
+// coding and file I/O run on a writer thread of its own. write() only copies the sample
+// into a bounded queue, so the poll thread never waits for the disk; samples that find
+// the queue full are dropped and counted.
+class OSVRSessionWriter
+{
+public:
+	enum { QUEUE_SIZE = 8192 }; // samples, a few seconds of reports
+
+	~OSVRSessionWriter() { close(); }
+
+	// precision is the position quantum in metres. open and close from one thread, the
+	// other calls from any thread
+	bool open(const std::string& path, double precision = 0.001);
+	void close();
+	bool isOpen() const { return is_open; }
+
+	// names a handle, call before its first sample
+	void addInterface(uint32_t handle, const std::string& path);
+	void write(const OSVRPoseSample& sample);
+
+	// samples dropped on a full queue since open
+	uint64_t getDropped() const { return dropped; }
+
+private:
+	void threadFunction();
+	void writePending(std::vector<OSVRPoseSample>& samples, std::vector<std::pair<uint32_t, std::string>>& names);
+	void encode(const OSVRPoseSample& sample);
+	void flushBlock();
+
+	// shared with the writer thread
+	std::mutex mtx;
+	std::condition_variable cv;
+	std::thread thd;
+	std::atomic<bool> is_open{ false };
+	bool is_thread_running = false;
+	std::vector<OSVRPoseSample> queue; // ring of QUEUE_SIZE
+	size_t queue_begin = 0;
+	size_t queue_count = 0;
+	std::vector<std::pair<uint32_t, std::string>> names; // added interfaces not written yet
+	std::atomic<uint64_t> dropped{ 0 };
+
+	// owned by the writer thread while it runs
+	std::ofstream file;
+	OSVRPoseEncoder encoder;
+	std::vector<uint8_t> block;
+	uint32_t block_samples = 0;
+	int64_t block_begin = 0;
+	int64_t block_end = 0;
+};
+
+class OSVRSessionReader
+{
+public:
+	struct Block
+	{
+		uint64_t offset; // of the coded samples in the file
+		uint32_t size;
+		uint32_t samples;
+		int64_t begin; // first and last report time, microseconds
+		int64_t end;
+	};
+
+	~OSVRSessionReader() { close(); }
+
+	// reads the header and indexes every chunk, false if this is no session file
+	bool open(const std::string& path);
+	void close();
+
+	// interface paths by handle, empty for handles never named
+	const std::vector<std::string>& getInterfaces() const { return interfaces; }
+	const std::vector<Block>& getBlocks() const { return blocks; }
+	double getPrecision() const { return precision; }
+	int64_t getBeginTime() const { return blocks.empty() ? 0 : blocks.front().begin; }
+	int64_t getEndTime() const { return blocks.empty() ? 0 : blocks.back().end; }
+
+	// sequential reading, next() is false at the end of the session
+	bool seek(int64_t timestamp);
+	bool next(OSVRPoseSample& sample);
+
+	// decodes one whole block into out. safe to call from several threads at once, each
+	// call decodes with its own state
+	bool readBlock(size_t index, std::vector<OSVRPoseSample>& out);
+
+private:
+	bool loadBlock(size_t index, std::vector<uint8_t>& data);
+	const char* pathOf(uint32_t handle) const;
+
+	std::mutex mtx; // guards file
+	std::ifstream file;
+	double precision = 0.001;
+	std::vector<std::string> interfaces;
+	std::vector<Block> blocks;
+
+	OSVRPoseDecoder decoder;
+	std::vector<uint8_t> data;
+	size_t block_index = 0;
+	size_t position = 0;
+	bool has_block = false;
+};
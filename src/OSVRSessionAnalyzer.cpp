@@ -0,0 +1,354 @@
+#include "OSVRSessionAnalyzer.h"
+#include "OSVRLog.h"
+
+#include <cmath>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+	const char* module = "OSVR";
+
+	// interval histogram for the percentiles, 0.05 ms bins up to 200 ms, reported by lower edge
+	const double FINE_BIN_MS = 0.05;
+	const size_t NUM_FINE_BINS = 4000;
+
+	const double RAD_TO_DEG = 57.295779513082320876;
+
+	template <class F>
+	void runParallel(unsigned count, F f)
+	{
+		vector<thread> workers;
+		workers.reserve(count);
+		for (unsigned i = 0; i < count; i++)
+			workers.emplace_back(f, i);
+		for (auto& w : workers)
+			w.join();
+	}
+
+	// every worker waits until all of them arrived, reusable
+	class Barrier
+	{
+	public:
+		explicit Barrier(unsigned count) :count(count) {}
+
+		void wait()
+		{
+			unique_lock<mutex> guard(mtx);
+			uint64_t current = generation;
+			if (++arrived == count)
+			{
+				arrived = 0;
+				generation++;
+				cv.notify_all();
+			}
+			else
+				cv.wait(guard, [&] { return generation != current; });
+		}
+
+	private:
+		mutex mtx;
+		condition_variable cv;
+		const unsigned count;
+		unsigned arrived = 0;
+		uint64_t generation = 0;
+	};
+
+	void addEvent(vector<OSVRInterfaceReport::Event>& events, size_t max_events, int64_t timestamp, double value)
+	{
+		if (events.size() < max_events)
+			events.push_back({ timestamp, value });
+	}
+
+	void writeString(ostream& out, const string& s)
+	{
+		out << '"';
+		for (char c : s)
+		{
+			if (c == '"' || c == '\\')
+				out << '\\' << c;
+			else if ((unsigned char)c < 0x20)
+			{
+				const char* hex = "0123456789abcdef";
+				out << "\\u00" << hex[(c >> 4) & 0xf] << hex[c & 0xf];
+			}
+			else
+				out << c;
+		}
+		out << '"';
+	}
+
+	void writeEvents(ostream& out, const char* name, const vector<OSVRInterfaceReport::Event>& events)
+	{
+		out << "\"" << name << "\":[";
+		for (size_t i = 0; i < events.size(); i++)
+			out << (i ? "," : "") << "{\"timestamp\":" << events[i].timestamp << ",\"value\":" << events[i].value << "}";
+		out << "]";
+	}
+}
+
+const double OSVRSessionAnalyzer::HISTOGRAM_EDGES_MS[] = { 0.5, 1, 2, 4, 8, 16, 32, 64, 128 };
+const size_t OSVRSessionAnalyzer::NUM_HISTOGRAM_EDGES = sizeof(HISTOGRAM_EDGES_MS) / sizeof(HISTOGRAM_EDGES_MS[0]);
+
+struct OSVRSessionAnalyzer::Accumulator
+{
+	OSVRInterfaceReport report;
+	bool has_previous = false;
+	bool has_valid = false;
+	int64_t previous_timestamp = 0;
+	float position[3];
+	float rotation[4];
+	double interval_sum = 0.0;
+	double interval_sum_sq = 0.0;
+	uint64_t intervals = 0;
+	vector<uint32_t> fine_bins;
+
+	void add(const OSVRPoseSample& s, const OSVRAnalyzerOptions& options)
+	{
+		if (report.samples == 0)
+		{
+			report.handle = s.handle;
+			report.begin = s.timestamp;
+			report.end = s.timestamp;
+			report.interval_histogram.assign(NUM_HISTOGRAM_EDGES + 1, 0);
+			fine_bins.assign(NUM_FINE_BINS + 1, 0);
+		}
+		report.samples++;
+		report.begin = std::min(report.begin, s.timestamp);
+		report.end = std::max(report.end, s.timestamp);
+
+		if (has_previous)
+		{
+			int64_t dt = s.timestamp - previous_timestamp;
+			if (dt <= 0)
+			{
+				report.non_monotonic++;
+				addEvent(report.non_monotonic_events, options.max_events, s.timestamp, dt / 1000.0);
+			}
+			else
+			{
+				double ms = dt / 1000.0;
+				interval_sum += ms;
+				interval_sum_sq += ms * ms;
+				intervals++;
+				report.interval_max = std::max(report.interval_max, ms);
+
+				size_t bucket = size_t(std::upper_bound(HISTOGRAM_EDGES_MS, HISTOGRAM_EDGES_MS + NUM_HISTOGRAM_EDGES, ms) - HISTOGRAM_EDGES_MS);
+				report.interval_histogram[bucket]++;
+				fine_bins[std::min(NUM_FINE_BINS, size_t(ms / FINE_BIN_MS))]++;
+
+				if (ms > options.dropout_ms)
+				{
+					report.dropouts++;
+					addEvent(report.dropout_events, options.max_events, previous_timestamp, ms);
+				}
+			}
+		}
+		has_previous = true;
+		previous_timestamp = s.timestamp;
+
+		const float* q = s.rotation;
+		double norm_error = std::fabs(std::sqrt(double(q[0]) * q[0] + double(q[1]) * q[1] + double(q[2]) * q[2] + double(q[3]) * q[3]) - 1.0);
+		report.max_norm_error = std::max(report.max_norm_error, norm_error);
+		if (norm_error > options.norm_tolerance)
+		{
+			report.norm_violations++;
+			addEvent(report.norm_events, options.max_events, s.timestamp, norm_error);
+		}
+
+		if (!s.valid)
+		{
+			report.invalid++;
+			return;
+		}
+
+		// jumps between consecutive valid reports
+		if (has_valid)
+		{
+			double dx = s.translation[0] - position[0];
+			double dy = s.translation[1] - position[1];
+			double dz = s.translation[2] - position[2];
+			double distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+			if (distance > options.jump_meters)
+			{
+				report.position_jumps++;
+				addEvent(report.jump_events, options.max_events, s.timestamp, distance);
+			}
+
+			double dot = 0.0, na = 0.0, nb = 0.0;
+			for (int i = 0; i < 4; i++)
+			{
+				dot += double(q[i]) * rotation[i];
+				na += double(q[i]) * q[i];
+				nb += double(rotation[i]) * rotation[i];
+			}
+			if (na > 0.0 && nb > 0.0)
+			{
+				double c = std::min(1.0, std::fabs(dot) / std::sqrt(na * nb));
+				double degrees = 2.0 * std::acos(c) * RAD_TO_DEG;
+				if (degrees > options.jump_degrees)
+				{
+					report.rotation_jumps++;
+					addEvent(report.jump_events, options.max_events, s.timestamp, degrees);
+				}
+			}
+		}
+		has_valid = true;
+		std::copy(s.translation, s.translation + 3, position);
+		std::copy(s.rotation, s.rotation + 4, rotation);
+	}
+
+	double percentile(double p) const
+	{
+		uint64_t target = uint64_t(std::ceil(p * intervals));
+		uint64_t count = 0;
+		for (size_t i = 0; i < NUM_FINE_BINS; i++)
+		{
+			count += fine_bins[i];
+			if (count >= target)
+				return std::min(i * FINE_BIN_MS, report.interval_max);
+		}
+		return report.interval_max;
+	}
+
+	void finish()
+	{
+		if (intervals > 0)
+		{
+			report.interval_mean = interval_sum / intervals;
+			report.interval_stddev = std::sqrt(std::max(0.0, interval_sum_sq / intervals - report.interval_mean * report.interval_mean));
+			report.interval_p50 = percentile(0.5);
+			report.interval_p99 = percentile(0.99);
+		}
+		if (report.end > report.begin)
+			report.rate_hz = (report.samples - 1) / ((report.end - report.begin) / 1e6);
+	}
+};
+
+OSVRSessionAnalyzer::OSVRSessionAnalyzer(const OSVRAnalyzerOptions& options)
+	:options(options)
+{
+
+}
+
+bool OSVRSessionAnalyzer::analyze(OSVRSessionReader& reader)
+{
+	reports.clear();
+
+	unsigned num_threads = options.threads ? options.threads : std::max(1u, thread::hardware_concurrency());
+	size_t num_blocks = reader.getBlocks().size();
+	num_threads = unsigned(std::max<size_t>(1, std::min<size_t>(num_threads, num_blocks)));
+
+	// interfaces are dealt to the workers up front, named ones round robin so every worker
+	// gets its share even when handles are sparse. the decoder rejects larger handles
+	auto& paths = reader.getInterfaces();
+	vector<unsigned> owner(OSVRPoseSample::MAX_HANDLES);
+	unsigned named = 0;
+	for (size_t h = 0; h < owner.size(); h++)
+		owner[h] = h < paths.size() && paths[h].empty() == false ? named++ % num_threads : unsigned(h % num_threads);
+
+	// each handle is only ever touched by its owner
+	vector<Accumulator> accumulators(OSVRPoseSample::MAX_HANDLES);
+	// window[b] is the block decoded by worker b, own[b][t] the indices of its samples owned by t
+	vector<vector<OSVRPoseSample>> window(num_threads);
+	vector<vector<vector<uint32_t>>> own(num_threads, vector<vector<uint32_t>>(num_threads));
+	vector<char> decoded(num_blocks, 0);
+	Barrier barrier(num_threads);
+
+	// the workers run once over the whole session, a window of one block per worker at a time
+	runParallel(num_threads, [&](unsigned t)
+	{
+		for (size_t first = 0; first < num_blocks; first += num_threads)
+		{
+			for (auto& indices : own[t])
+				indices.clear();
+			if (first + t < num_blocks)
+			{
+				decoded[first + t] = reader.readBlock(first + t, window[t]);
+				for (size_t i = 0; i < window[t].size(); i++)
+					own[t][owner[window[t][i].handle]].push_back(uint32_t(i));
+			}
+			barrier.wait();
+
+			for (unsigned b = 0; b < num_threads; b++)
+			{
+				for (uint32_t i : own[b][t])
+				{
+					const OSVRPoseSample& s = window[b][i];
+					accumulators[s.handle].add(s, options);
+				}
+			}
+			barrier.wait();
+		}
+	});
+
+	bool complete = true;
+	for (size_t b = 0; b < num_blocks; b++)
+	{
+		if (!decoded[b])
+		{
+			OSVRLog::warning(module, "session block %u is corrupt, analyzing what decoded", unsigned(b));
+			complete = false;
+		}
+	}
+
+	for (auto& acc : accumulators)
+	{
+		if (acc.report.samples == 0)
+			continue;
+		acc.finish();
+		if (acc.report.handle < paths.size())
+			acc.report.path = paths[acc.report.handle];
+		reports.push_back(std::move(acc.report));
+	}
+	return complete;
+}
+
+void OSVRSessionAnalyzer::writeJson(ostream& out) const
+{
+	out << "{\"options\":{"
+		<< "\"dropout_ms\":" << options.dropout_ms
+		<< ",\"jump_meters\":" << options.jump_meters
+		<< ",\"jump_degrees\":" << options.jump_degrees
+		<< ",\"norm_tolerance\":" << options.norm_tolerance
+		<< "},\"histogram_edges_ms\":[";
+	for (size_t i = 0; i < NUM_HISTOGRAM_EDGES; i++)
+		out << (i ? "," : "") << HISTOGRAM_EDGES_MS[i];
+	out << "],\"interfaces\":[";
+
+	for (size_t i = 0; i < reports.size(); i++)
+	{
+		auto& r = reports[i];
+		out << (i ? "," : "") << "\n{\"handle\":" << r.handle << ",\"path\":";
+		writeString(out, r.path);
+		out << ",\"samples\":" << r.samples
+			<< ",\"invalid\":" << r.invalid
+			<< ",\"begin\":" << r.begin
+			<< ",\"end\":" << r.end
+			<< ",\"rate_hz\":" << r.rate_hz
+			<< ",\"interval_ms\":{\"mean\":" << r.interval_mean
+			<< ",\"stddev\":" << r.interval_stddev
+			<< ",\"p50\":" << r.interval_p50
+			<< ",\"p99\":" << r.interval_p99
+			<< ",\"max\":" << r.interval_max
+			<< ",\"histogram\":[";
+		for (size_t k = 0; k < r.interval_histogram.size(); k++)
+			out << (k ? "," : "") << r.interval_histogram[k];
+		out << "]},\"dropouts\":" << r.dropouts << ",";
+		writeEvents(out, "dropout_events", r.dropout_events);
+		out << ",\"position_jumps\":" << r.position_jumps
+			<< ",\"rotation_jumps\":" << r.rotation_jumps << ",";
+		writeEvents(out, "jump_events", r.jump_events);
+		out << ",\"norm_violations\":" << r.norm_violations
+			<< ",\"max_norm_error\":" << r.max_norm_error << ",";
+		writeEvents(out, "norm_events", r.norm_events);
+		out << ",\"non_monotonic\":" << r.non_monotonic << ",";
+		writeEvents(out, "non_monotonic_events", r.non_monotonic_events);
+		out << "}";
+	}
+	out << "\n]}\n";
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstdint>
+
+#include "OSVRSession.h"
+
+// tracking-quality summary of a recorded session, one report per interface
+//
+// the worker threads start once and each owns a fixed share of the interfaces. blocks are
+// decoded a window at a time, one block per worker, which sorts the samples by owner; then
+// every worker walks only the samples of its own interfaces. memory stays at a few blocks
+// no matter how long the session is.
+
+struct OSVRAnalyzerOptions
+{
+	double dropout_ms = 50.0;      // report gaps longer than this
+	double jump_meters = 0.1;      // position change between two reports counted as a teleport
+	double jump_degrees = 45.0;    // same for rotation
+	double norm_tolerance = 1e-3;  // allowed | |q| - 1 |
+	size_t max_events = 100;       // listed per kind and interface, counting never stops
+	unsigned threads = 0;          // 0 uses every hardware thread
+};
+
+struct OSVRInterfaceReport
+{
+	struct Event
+	{
+		int64_t timestamp; // OSVR report time, microseconds
+		double value;      // gap in ms, jump in metres or degrees, norm error
+	};
+
+	uint32_t handle = 0;
+	std::string path;
+
+	uint64_t samples = 0;
+	uint64_t invalid = 0;
+	int64_t begin = 0;
+	int64_t end = 0;
+	double rate_hz = 0.0;
+
+	// report intervals in ms, the histogram counts intervals below each of
+	// OSVRSessionAnalyzer::HISTOGRAM_EDGES_MS plus one bucket for everything above
+	double interval_mean = 0.0;
+	double interval_stddev = 0.0;
+	double interval_p50 = 0.0;
+	double interval_p99 = 0.0;
+	double interval_max = 0.0;
+	std::vector<uint64_t> interval_histogram;
+
+	uint64_t dropouts = 0;
+	std::vector<Event> dropout_events;
+
+	uint64_t position_jumps = 0;
+	uint64_t rotation_jumps = 0;
+	std::vector<Event> jump_events; // value in metres for position, degrees for rotation
+
+	uint64_t norm_violations = 0;
+	double max_norm_error = 0.0;
+	std::vector<Event> norm_events;
+
+	uint64_t non_monotonic = 0; // reports not newer than the one before
+	std::vector<Event> non_monotonic_events;
+};
+
+class OSVRSessionAnalyzer
+{
+public:
+	static const double HISTOGRAM_EDGES_MS[];
+	static const size_t NUM_HISTOGRAM_EDGES;
+
+	explicit OSVRSessionAnalyzer(const OSVRAnalyzerOptions& options = OSVRAnalyzerOptions());
+
+	bool analyze(OSVRSessionReader& reader);
+
+	const std::vector<OSVRInterfaceReport>& getReports() const { return reports; }
+
+	// the options and every report as one JSON object
+	void writeJson(std::ostream& out) const;
+
+private:
+	struct Accumulator;
+
+	OSVRAnalyzerOptions options;
+	std::vector<OSVRInterfaceReport> reports;
+};
@@ -0,0 +1,214 @@
+#include "OSVRSharedMemory.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+#ifdef _WIN32
+	string segmentName(const string& name)
+	{
+		return "Local\\" + name;
+	}
+
+	void* mapSegment(const string& name, bool writable, void*& handle)
+	{
+		HANDLE mapping;
+		if (writable)
+			mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(OSVRSharedFrame), segmentName(name).c_str());
+		else
+			mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, segmentName(name).c_str());
+		if (mapping == nullptr)
+			return nullptr;
+
+		void* ptr = MapViewOfFile(mapping, writable ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, sizeof(OSVRSharedFrame));
+		if (ptr == nullptr)
+		{
+			CloseHandle(mapping);
+			return nullptr;
+		}
+		handle = mapping;
+		return ptr;
+	}
+
+	void unmapSegment(const void* ptr, void* handle)
+	{
+		UnmapViewOfFile(ptr);
+		CloseHandle(handle);
+	}
+#else
+	string segmentName(const string& name)
+	{
+		return "/" + name;
+	}
+
+	void* mapSegment(const string& name, bool writable, void*& handle)
+	{
+		int fd = shm_open(segmentName(name).c_str(), writable ? O_CREAT | O_RDWR : O_RDONLY, 0644);
+		if (fd < 0)
+			return nullptr;
+
+		if (writable && ftruncate(fd, sizeof(OSVRSharedFrame)) != 0)
+		{
+			::close(fd);
+			return nullptr;
+		}
+
+		struct stat st;
+		if (!writable && (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(OSVRSharedFrame)))
+		{
+			::close(fd);
+			return nullptr;
+		}
+
+		void* ptr = mmap(nullptr, sizeof(OSVRSharedFrame), writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+		// the mapping keeps the segment alive
+		::close(fd);
+		handle = nullptr;
+		return ptr == MAP_FAILED ? nullptr : ptr;
+	}
+
+	void unmapSegment(const void* ptr, void*)
+	{
+		munmap(const_cast<void*>(ptr), sizeof(OSVRSharedFrame));
+	}
+#endif
+}
+
+bool OSVRSharedMemoryWriter::open(const string& name)
+{
+	close();
+
+	void* ptr = mapSegment(name, true, handle);
+	if (ptr == nullptr)
+		return false;
+
+	frame = static_cast<OSVRSharedFrame*>(ptr);
+	segment_name = name;
+
+	// readers reject the segment until the header is complete
+	frame->magic = 0;
+	frame->seq.store(0, memory_order_relaxed);
+	frame->version = OSVRSharedFrame::VERSION;
+	frame->size = sizeof(OSVRSharedFrame);
+	frame->tick = 0;
+	frame->num_interfaces = 0;
+	frame->num_eyes = 0;
+	atomic_thread_fence(memory_order_release);
+	frame->magic = OSVRSharedFrame::MAGIC;
+	return true;
+}
+
+void OSVRSharedMemoryWriter::close()
+{
+	if (frame == nullptr)
+		return;
+
+	frame->magic = 0;
+	unmapSegment(frame, handle);
+#ifndef _WIN32
+	shm_unlink(segmentName(segment_name).c_str());
+#endif
+	frame = nullptr;
+	handle = nullptr;
+}
+
+OSVRSharedFrame* OSVRSharedMemoryWriter::beginWrite()
+{
+	if (frame == nullptr)
+		return nullptr;
+
+	frame->seq.store(frame->seq.load(memory_order_relaxed) + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	return frame;
+}
+
+void OSVRSharedMemoryWriter::endWrite()
+{
+	frame->seq.store(frame->seq.load(memory_order_relaxed) + 1, memory_order_release);
+}
+
+bool OSVRSharedMemoryReader::open(const string& name)
+{
+	close();
+
+	void* ptr = mapSegment(name, false, handle);
+	if (ptr == nullptr)
+		return false;
+
+	auto mapped = static_cast<const OSVRSharedFrame*>(ptr);
+	if (mapped->magic != OSVRSharedFrame::MAGIC || mapped->version != OSVRSharedFrame::VERSION || mapped->size != sizeof(OSVRSharedFrame))
+	{
+		unmapSegment(mapped, handle);
+		handle = nullptr;
+		return false;
+	}
+
+	frame = mapped;
+	return true;
+}
+
+void OSVRSharedMemoryReader::close()
+{
+	if (frame == nullptr)
+		return;
+
+	unmapSegment(frame, handle);
+	frame = nullptr;
+	handle = nullptr;
+}
+
+bool OSVRSharedMemoryReader::getInterfacePose(uint32_t handle, float translation[3], float rotation[4], int64_t* timestamp) const
+{
+	if (handle >= OSVRSharedFrame::MAX_INTERFACES)
+		return false;
+
+	bool valid = false;
+	bool consistent = read([&](const OSVRSharedFrame& f)
+	{
+		auto& face = f.interfaces[handle];
+		valid = handle < f.num_interfaces && face.valid != 0;
+		memcpy(translation, face.translation, sizeof(face.translation));
+		memcpy(rotation, face.rotation, sizeof(face.rotation));
+		if (timestamp)
+			*timestamp = face.timestamp;
+	});
+	return consistent && valid;
+}
+
+uint32_t OSVRSharedMemoryReader::findInterface(const string& path) const
+{
+	uint32_t found = INVALID_INTERFACE;
+	read([&](const OSVRSharedFrame& f)
+	{
+		found = INVALID_INTERFACE;
+		for (uint32_t i = 0; i < f.num_interfaces && i < OSVRSharedFrame::MAX_INTERFACES; i++)
+		{
+			if (OSVRSharedFrame::matchesPath(f.interfaces[i], path))
+			{
+				found = i;
+				break;
+			}
+		}
+	});
+	return found;
+}
+
+uint64_t OSVRSharedMemoryReader::getTick() const
+{
+	uint64_t tick = 0;
+	read([&](const OSVRSharedFrame& f) { tick = f.tick; });
+	return tick;
+}
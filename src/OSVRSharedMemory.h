@@ -0,0 +1,162 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+// latest tracking frame in a named shared-memory segment, for sibling processes
+//
+// one writer (the tracking core's poll thread) and any number of read-only readers. the
+// segment is guarded by a sequence counter: odd while a frame is being written, readers
+// retry when it changed under them. readers work on the mapped memory directly, so a read
+// costs no syscall and copies only what the caller takes out.
+//
+// this header and OSVRSharedMemory.cpp depend on neither OSVR nor openFrameworks, a
+// consumer process only needs these two files.
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "the shared frame needs a lock-free, address-free counter");
+
+struct OSVRSharedFrame
+{
+	enum {
+		MAGIC = 0x5256534f, // "OSVR"
+		VERSION = 3,
+		MAX_INTERFACES = 4096, // every handle the tracking core can give out, about 500 KB
+		MAX_PATH_LENGTH = 64,
+		MAX_EYES = 8,
+		MAX_SURFACES = 2
+	};
+
+	struct Interface
+	{
+		// the first MAX_PATH_LENGTH - 1 characters, longer paths are told apart by their
+		// full length and hash. see setPath and matchesPath
+		char path[MAX_PATH_LENGTH];
+		uint32_t path_length;
+		uint32_t path_hash;
+		float translation[3];
+		float rotation[4]; // x, y, z, w
+		int64_t timestamp; // steady_clock nanoseconds, comparable between processes on one machine
+		int64_t osvr_seconds; // raw OSVR report time
+		int32_t osvr_microseconds;
+		uint32_t valid;
+	};
+
+	struct Surface
+	{
+		uint32_t surface_id;
+		float projection_matrix[16];
+		float viewport[4]; // x, y, width, height, relative to the display
+	};
+
+	struct Eye
+	{
+		uint32_t viewer_id;
+		uint32_t eye_id;
+		float modelview_matrix[16];
+		uint32_t num_surfaces;
+		Surface surfaces[MAX_SURFACES];
+	};
+
+	// FNV-1a, the same on every platform
+	static uint32_t hashPath(const char* path, size_t length)
+	{
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i < length; i++)
+			hash = (hash ^ uint8_t(path[i])) * 16777619u;
+		return hash;
+	}
+
+	static void setPath(Interface& face, const std::string& path)
+	{
+		size_t length = path.size() < MAX_PATH_LENGTH - 1 ? path.size() : MAX_PATH_LENGTH - 1;
+		std::memcpy(face.path, path.data(), length);
+		face.path[length] = '\0';
+		face.path_length = uint32_t(path.size());
+		face.path_hash = hashPath(path.data(), path.size());
+	}
+
+	static bool matchesPath(const Interface& face, const std::string& path)
+	{
+		size_t length = path.size() < MAX_PATH_LENGTH - 1 ? path.size() : MAX_PATH_LENGTH - 1;
+		return face.path_length == path.size() && std::memcmp(face.path, path.data(), length) == 0
+			&& face.path_hash == hashPath(path.data(), path.size());
+	}
+
+	uint32_t magic;
+	uint32_t version;
+	uint32_t size;
+	std::atomic<uint32_t> seq;
+	uint64_t tick;
+	uint32_t num_interfaces;
+	uint32_t num_eyes;
+	Interface interfaces[MAX_INTERFACES]; // indexed by interface handle
+	Eye eyes[MAX_EYES];
+};
+
+class OSVRSharedMemoryWriter
+{
+public:
+	~OSVRSharedMemoryWriter() { close(); }
+
+	// creates or reuses the segment, the name is a plain identifier such as "osvr"
+	bool open(const std::string& name);
+	void close();
+	bool isOpen() const { return frame != nullptr; }
+
+	// every beginWrite must be followed by endWrite on the same thread
+	OSVRSharedFrame* beginWrite();
+	void endWrite();
+
+private:
+	OSVRSharedFrame* frame = nullptr;
+	std::string segment_name;
+	void* handle = nullptr;
+};
+
+class OSVRSharedMemoryReader
+{
+public:
+	static const uint32_t INVALID_INTERFACE = ~0u;
+
+	~OSVRSharedMemoryReader() { close(); }
+
+	// maps an existing segment read-only, false while no writer has created it
+	bool open(const std::string& name);
+	void close();
+	bool isOpen() const { return frame != nullptr; }
+
+	// calls f with a consistent frame. f may run more than once and must only copy data
+	// out; false when the writer kept the frame busy for every attempt
+	template <class F>
+	bool read(F f, int attempts = 100) const
+	{
+		for (int i = 0; i < attempts && frame; i++)
+		{
+			uint32_t begin = frame->seq.load(std::memory_order_acquire);
+			if (begin & 1)
+				continue;
+			// the writer closed the segment
+			if (frame->magic != OSVRSharedFrame::MAGIC)
+				return false;
+			f(*frame);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (frame->seq.load(std::memory_order_relaxed) == begin)
+				return true;
+		}
+		return false;
+	}
+
+	// one interface by the handle its writer gave it
+	bool getInterfacePose(uint32_t handle, float translation[3], float rotation[4], int64_t* timestamp = nullptr) const;
+	// linear search by path, resolve once with findInterface in per-frame code
+	uint32_t findInterface(const std::string& path) const;
+
+	uint64_t getTick() const;
+
+private:
+	const OSVRSharedFrame* frame = nullptr;
+	void* handle = nullptr;
+};
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+
+#include "OSVRDelegate.h"
+
+// callbacks run by one dispatching thread, added and removed from any thread lock-free
+//
+// subscribers live in a fixed array of slots. a slot is claimed with a compare-exchange,
+// filled, then marked active; dispatch only calls active slots. remove() returns once the
+// callback can't be running anymore, except when called from inside a callback, where
+// the slot is released after the current dispatch. a key filters what a subscriber gets,
+// ANY_KEY takes everything.
+template <class Delegate, size_t Capacity = 64>
+class OSVRSubscribers
+{
+public:
+	typedef uint32_t Id; // 0 is never a valid id
+	static const uint32_t ANY_KEY = ~0u;
+
+	static_assert(Capacity < 256, "the slot index takes the low byte of an id");
+
+	OSVRSubscribers()
+	{
+		for (auto& s : slots)
+		{
+			s.state.store(FREE, std::memory_order_relaxed);
+			s.generation.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	// 0 when every slot is taken
+	Id add(uint32_t key, const Delegate& delegate)
+	{
+		for (uint32_t i = 0; i < Capacity; i++)
+		{
+			Slot& s = slots[i];
+			uint32_t expected = FREE;
+			if (s.state.compare_exchange_strong(expected, CLAIMED, std::memory_order_acquire) == false)
+				continue;
+			s.key = key;
+			s.delegate = delegate;
+			// 23 bits, the top bit of an id is left to the owner
+			uint32_t generation = (s.generation.load(std::memory_order_relaxed) + 1) & 0x7fffff;
+			generation = generation == 0 ? 1 : generation;
+			s.generation.store(generation, std::memory_order_relaxed);
+			Id id = (generation << 8) | (i + 1);
+			s.state.store(ACTIVE, std::memory_order_release);
+
+			// grow the range dispatch looks at
+			uint32_t used = num_used.load(std::memory_order_relaxed);
+			while (used < i + 1 && num_used.compare_exchange_weak(used, i + 1, std::memory_order_release) == false)
+				;
+			return id;
+		}
+		return 0;
+	}
+
+	void remove(Id id)
+	{
+		uint32_t i = (id & 0xff) - 1;
+		if (id == 0 || i >= Capacity)
+			return;
+		Slot& s = slots[i];
+		uint32_t expected = ACTIVE;
+		if ((s.generation.load(std::memory_order_relaxed) << 8 | (i + 1)) != id || s.state.compare_exchange_strong(expected, REMOVING) == false)
+			return;
+
+		// from inside a callback, dispatch frees the slot when it is done
+		if (dispatch_thread.load() == std::this_thread::get_id())
+			return;
+
+		// wait out a dispatch that may have picked the slot before it was marked. store then
+		// load on both sides, so the CAS above, this load and the ones in beginDispatch and
+		// dispatch are all sequentially consistent: either dispatch sees REMOVING or this
+		// sees its odd sequence
+		uint32_t seq = dispatch_seq.load();
+		while ((seq & 1) && dispatch_seq.load(std::memory_order_acquire) == seq)
+			std::this_thread::yield();
+		expected = REMOVING;
+		s.state.compare_exchange_strong(expected, FREE, std::memory_order_release);
+	}
+
+	bool empty() const { return countActive() == 0; }
+
+	// dispatching thread. calls every active subscriber whose key is key or ANY_KEY
+	template <class... Args>
+	void dispatch(uint32_t key, Args&&... args)
+	{
+		beginDispatch();
+		uint32_t used = num_used.load(std::memory_order_acquire);
+		for (uint32_t i = 0; i < used; i++)
+		{
+			Slot& s = slots[i];
+			if (s.state.load() != ACTIVE)
+				continue;
+			if (s.key == key || s.key == ANY_KEY)
+				s.delegate(args...);
+		}
+		endDispatch();
+	}
+
+	// dispatching thread, brackets several dispatch() calls so they count as one for
+	// remove(). nested calls are fine
+	void beginDispatch()
+	{
+		if (depth++ > 0)
+			return;
+		dispatch_thread.store(std::this_thread::get_id());
+		dispatch_seq.fetch_add(1);
+	}
+
+	void endDispatch()
+	{
+		if (--depth > 0)
+			return;
+		dispatch_seq.fetch_add(1, std::memory_order_release);
+		dispatch_thread.store(std::thread::id());
+
+		// slots removed from inside callbacks
+		uint32_t used = num_used.load(std::memory_order_acquire);
+		for (uint32_t i = 0; i < used; i++)
+		{
+			uint32_t expected = REMOVING;
+			slots[i].state.compare_exchange_strong(expected, FREE, std::memory_order_release);
+		}
+	}
+
+private:
+	enum : uint32_t {
+		FREE,
+		CLAIMED,
+		ACTIVE,
+		REMOVING
+	};
+
+	struct Slot
+	{
+		std::atomic<uint32_t> state;
+		std::atomic<uint32_t> generation; // written by the claiming thread only
+		uint32_t key;
+		Delegate delegate;
+	};
+
+	size_t countActive() const
+	{
+		size_t count = 0;
+		uint32_t used = num_used.load(std::memory_order_acquire);
+		for (uint32_t i = 0; i < used; i++)
+			count += slots[i].state.load(std::memory_order_relaxed) == ACTIVE ? 1 : 0;
+		return count;
+	}
+
+	std::array<Slot, Capacity> slots;
+	std::atomic<uint32_t> num_used{ 0 };
+	std::atomic<uint32_t> dispatch_seq{ 0 }; // odd while dispatching
+	std::atomic<std::thread::id> dispatch_thread;
+	int depth = 0; // dispatching thread only
+};
@@ -0,0 +1,117 @@
+#include "OSVRThread.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+using namespace std;
+
+namespace OSVRThread
+{
+	bool setName(const string& name)
+	{
+#if defined(_WIN32)
+		// SetThreadDescription is Windows 10 1607 and later, look it up instead of linking it
+		typedef HRESULT(WINAPI *SetThreadDescriptionFn)(HANDLE, PCWSTR);
+		auto fn = reinterpret_cast<SetThreadDescriptionFn>(GetProcAddress(GetModuleHandleA("kernel32.dll"), "SetThreadDescription"));
+		if (fn == nullptr)
+			return false;
+		wstring wide(name.begin(), name.end());
+		return SUCCEEDED(fn(GetCurrentThread(), wide.c_str()));
+#elif defined(__APPLE__)
+		return pthread_setname_np(name.c_str()) == 0;
+#elif defined(__linux__)
+		// the kernel keeps 15 characters and refuses longer names
+		return pthread_setname_np(pthread_self(), name.substr(0, 15).c_str()) == 0;
+#else
+		return false;
+#endif
+	}
+
+	bool setAffinity(const vector<int>& cpus)
+	{
+		if (cpus.empty())
+			return true;
+#if defined(_WIN32)
+		DWORD_PTR mask = 0;
+		for (int cpu : cpus)
+		{
+			if (cpu >= 0 && cpu < int(sizeof(DWORD_PTR) * 8))
+				mask |= DWORD_PTR(1) << cpu;
+		}
+		return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#elif defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (int cpu : cpus)
+		{
+			if (cpu >= 0 && cpu < CPU_SETSIZE)
+				CPU_SET(cpu, &set);
+		}
+		return CPU_COUNT(&set) > 0 && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+		// macOS only takes affinity hints between threads, not cores
+		return false;
+#endif
+	}
+
+	OSVRThreadPriority setPriority(OSVRThreadPriority priority, bool roundRobin, int realtimePriority)
+	{
+#if defined(_WIN32)
+		if (priority == OSVR_PRIORITY_REALTIME && SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL))
+			return OSVR_PRIORITY_REALTIME;
+		if (priority >= OSVR_PRIORITY_HIGH && SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST))
+			return OSVR_PRIORITY_HIGH;
+		SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_NORMAL);
+		return OSVR_PRIORITY_DEFAULT;
+#else
+		if (priority == OSVR_PRIORITY_REALTIME)
+		{
+			// needs CAP_SYS_NICE or an RLIMIT_RTPRIO allowance
+			int policy = roundRobin ? SCHED_RR : SCHED_FIFO;
+			sched_param param;
+			param.sched_priority = max(sched_get_priority_min(policy), min(realtimePriority, sched_get_priority_max(policy)));
+			if (pthread_setschedparam(pthread_self(), policy, &param) == 0)
+				return OSVR_PRIORITY_REALTIME;
+		}
+		else
+		{
+			// back to the time sharing class in case a realtime policy was set before
+			sched_param param;
+			param.sched_priority = 0;
+			pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+		}
+
+#ifdef __linux__
+		// the nice value is per thread on Linux
+		id_t tid = id_t(syscall(SYS_gettid));
+		if (priority >= OSVR_PRIORITY_HIGH && setpriority(PRIO_PROCESS, tid, -10) == 0)
+			return OSVR_PRIORITY_HIGH;
+		setpriority(PRIO_PROCESS, tid, 0);
+#endif
+		return OSVR_PRIORITY_DEFAULT;
+#endif
+	}
+
+	const char* getPriorityName(OSVRThreadPriority priority)
+	{
+		switch (priority)
+		{
+		case OSVR_PRIORITY_HIGH: return "high";
+		case OSVR_PRIORITY_REALTIME: return "realtime";
+		default: return "default";
+		}
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// scheduling of the calling thread: name, CPU affinity and priority
+//
+// every call works on the current thread only, so the poll thread applies its own
+// settings. anything the platform or the process privileges don't allow fails without
+// side effects and is reported through the return value.
+
+enum OSVRThreadPriority
+{
+	OSVR_PRIORITY_DEFAULT,
+	OSVR_PRIORITY_HIGH,     // above normal threads: nice -10 on Linux, THREAD_PRIORITY_HIGHEST on Windows
+	OSVR_PRIORITY_REALTIME  // SCHED_FIFO / SCHED_RR on Linux, THREAD_PRIORITY_TIME_CRITICAL on Windows
+};
+
+struct OSVRThreadOptions
+{
+	std::string name = "osvr poll"; // shown in debuggers and profilers, 15 characters on Linux
+	std::vector<int> cpus; // cores the thread may run on, empty for any
+	OSVRThreadPriority priority = OSVR_PRIORITY_DEFAULT;
+	bool round_robin = false; // SCHED_RR instead of SCHED_FIFO
+	int realtime_priority = 10; // 1 - 99 on Linux, keep it below audio and kernel threads
+};
+
+namespace OSVRThread
+{
+	bool setName(const std::string& name);
+	bool setAffinity(const std::vector<int>& cpus);
+
+	// tries the requested priority, then each lower one, and returns the one that was set
+	OSVRThreadPriority setPriority(OSVRThreadPriority priority, bool roundRobin = false, int realtimePriority = 10);
+
+	const char* getPriorityName(OSVRThreadPriority priority);
+}
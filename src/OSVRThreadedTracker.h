@@ -0,0 +1,211 @@
+#pragma once
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <map>
+#include <iterator>
+#include <string>
+#include <chrono>
+
+#include "OSVRTrackingCore.h"
+#include "OSVRThread.h"
+
+// how well the poll thread kept its schedule
+struct OSVRPollStats
+{
+	uint64_t ticks = 0;
+	uint64_t missed_deadlines = 0; // ticks that were still running when the next one was due
+	double mean_wake_latency = 0.0; // seconds a tick started after it was due
+	double max_wake_latency = 0.0;
+	double max_tick_time = 0.0; // seconds spent in one update()
+	OSVRThreadPriority priority = OSVR_PRIORITY_DEFAULT; // the one the thread actually got
+	bool affinity_set = false;
+};
+
+// a tracking core polled from its own thread, from construction until destruction
+template <class Core>
+class OSVRThreadedTracker : public Core
+{
+public:
+	using TrackingCore = Core;
+
+	OSVRThreadedTracker(std::string applicationIdentifier, bool serverAutoStart = true, const OSVRThreadOptions& options = OSVRThreadOptions(), std::string host = "")
+		:Core(applicationIdentifier, host)
+		,thread_options(options)
+	{
+		thd = std::thread(&OSVRThreadedTracker::threadFunction, this, serverAutoStart);
+	}
+
+	~OSVRThreadedTracker()
+	{
+		is_thread_running = false;
+		thd.join();
+		OSVRLog::notice(this->module, "clear");
+	}
+
+	// name, cores and priority of the poll thread, applied by the thread before its next tick
+	void setThreadOptions(const OSVRThreadOptions& options)
+	{
+		std::lock_guard<std::mutex> guard(stats_mutex);
+		thread_options = options;
+		has_pending_options = true;
+	}
+
+	OSVRPollStats getPollStats()
+	{
+		std::lock_guard<std::mutex> guard(stats_mutex);
+		return stats;
+	}
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	void threadFunction(bool serverAutoStart)
+	{
+		applyThreadOptions();
+
+		if (this->start(serverAutoStart) == false)
+			is_thread_running = false;
+
+		// ticks are due on a fixed grid, a late tick doesn't shift the ones after it. after a
+		// missed deadline the grid restarts instead of running the missed ticks back to back
+		auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::microseconds(1000000 / fps));
+		auto due = Clock::now();
+		while (is_thread_running)
+		{
+			if (has_pending_options.exchange(false))
+				applyThreadOptions();
+
+			auto begin = Clock::now();
+			this->update();
+			auto end = Clock::now();
+
+			due += period;
+			bool missed = end > due;
+			addTick(begin - (due - period), end - begin, missed);
+			if (missed)
+				due = end;
+
+			std::this_thread::sleep_until(due);
+		}
+
+		// the context belongs to this thread
+		this->stop();
+		OSVRLog::notice(this->module, "thread exit");
+	}
+
+	void applyThreadOptions()
+	{
+		OSVRThreadOptions options;
+		{
+			std::lock_guard<std::mutex> guard(stats_mutex);
+			options = thread_options;
+		}
+
+		if (options.name.empty() == false && OSVRThread::setName(options.name) == false)
+			OSVRLog::verbose(this->module, "could not name the poll thread");
+
+		bool affinity_set = options.cpus.empty() == false && OSVRThread::setAffinity(options.cpus);
+		if (options.cpus.empty() == false && affinity_set == false)
+			OSVRLog::warning(this->module, "could not set the poll thread affinity");
+
+		// leave the inherited priority alone until someone asks for one
+		OSVRThreadPriority priority = OSVR_PRIORITY_DEFAULT;
+		if (options.priority != OSVR_PRIORITY_DEFAULT || priority_changed)
+		{
+			priority = OSVRThread::setPriority(options.priority, options.round_robin, options.realtime_priority);
+			priority_changed = true;
+			if (priority != options.priority)
+				OSVRLog::warning(this->module, "poll thread priority %s is not allowed, running at %s",
+					OSVRThread::getPriorityName(options.priority), OSVRThread::getPriorityName(priority));
+		}
+
+		std::lock_guard<std::mutex> guard(stats_mutex);
+		stats.priority = priority;
+		stats.affinity_set = affinity_set;
+	}
+
+	void addTick(Clock::duration wakeLatency, Clock::duration tickTime, bool missed)
+	{
+		double latency = std::max(0.0, std::chrono::duration<double>(wakeLatency).count());
+		double time = std::chrono::duration<double>(tickTime).count();
+
+		std::lock_guard<std::mutex> guard(stats_mutex);
+		stats.ticks++;
+		stats.missed_deadlines += missed ? 1 : 0;
+		stats.mean_wake_latency += (latency - stats.mean_wake_latency) / double(stats.ticks);
+		stats.max_wake_latency = std::max(stats.max_wake_latency, latency);
+		stats.max_tick_time = std::max(stats.max_tick_time, time);
+	}
+
+	std::thread thd;
+	std::atomic<bool> is_thread_running{ true };
+	int fps = 60;
+
+	std::mutex stats_mutex; // guards stats and thread_options
+	OSVRPollStats stats;
+	OSVRThreadOptions thread_options;
+	std::atomic<bool> has_pending_options{ false };
+	bool priority_changed = false; // poll thread only
+};
+
+// one shared tracker per application identifier in this process
+//
+// subsystems that each acquire a tracker for the same application get the same instance:
+// one client context, one poll thread, one server auto start, one interface store, where
+// adding a path someone else added returns the existing handle. the tracker lives until
+// the last reference goes away; acquiring again after that starts a new one. the first
+// caller's construction arguments win.
+template <class Tracker>
+class OSVRTrackerRegistry
+{
+public:
+	using Ref = std::shared_ptr<Tracker>;
+
+	// create() builds the tracker when none is alive for this identifier
+	template <class F>
+	static Ref acquire(const std::string& applicationIdentifier, F create)
+	{
+		std::lock_guard<std::mutex> guard(getMutex());
+		auto& trackers = getTrackers();
+		for (auto it = trackers.begin(); it != trackers.end();)
+			it = it->second.expired() ? trackers.erase(it) : std::next(it);
+
+		auto& entry = trackers[applicationIdentifier];
+		Ref tracker = entry.lock();
+		if (tracker)
+		{
+			OSVRLog::verbose("OSVR", "sharing the tracker of %s", applicationIdentifier.c_str());
+			return tracker;
+		}
+		tracker = create();
+		entry = tracker;
+		return tracker;
+	}
+
+	static Ref acquire(const std::string& applicationIdentifier, bool serverAutoStart = true, const OSVRThreadOptions& options = OSVRThreadOptions())
+	{
+		return acquire(applicationIdentifier, [&]
+		{
+			return std::make_shared<Tracker>(applicationIdentifier, serverAutoStart, options);
+		});
+	}
+
+private:
+	static std::mutex& getMutex()
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	static std::map<std::string, std::weak_ptr<Tracker>>& getTrackers()
+	{
+		static std::map<std::string, std::weak_ptr<Tracker>> trackers;
+		return trackers;
+	}
+};
+
+// headless default, plain float types and no openFrameworks
+using OSVRTracker = OSVRThreadedTracker<OSVRTrackingCore<MutexLockPolicy, MapStoragePolicy, PodMathPolicy>>;
@@ -0,0 +1,1407 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <deque>
+#include <map>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <array>
+
+// ignore conflict define
+#pragma push_macro("ignore")
+#undef near
+#undef far
+#include "osvr/ClientKit/Context.h"
+#include "osvr/ClientKit/ContextC.h"
+#include "osvr/ClientKit/Interface.h"
+#include "osvr/ClientKit/Display.h"
+#include "osvr/ClientKit/DisplayC.h"
+#include "osvr/ClientKit/ServerAutoStartC.h"
+#include "osvr/ClientKit/InterfaceStateC.h"
+#include "osvr/ClientKit/InterfaceCallbackC.h"
+#pragma pop_macro("ignore")
+
+#include "OSVRClock.h"
+#include "OSVRLog.h"
+#include "OSVRFramePool.h"
+#include "OSVRPolicies.h"
+#include "OSVRPoseTable.h"
+#include "OSVRPoseBatch.h"
+#include "OSVRPoseFilter.h"
+#include "OSVRCalibration.h"
+#include "OSVRPrediction.h"
+#include "OSVREyes.h"
+#include "OSVRCameraBlock.h"
+#include "OSVRSubscribers.h"
+#include "OSVRWaitQueue.h"
+#include "OSVRCoroutines.h"
+#include "OSVRSharedMemory.h"
+#include "OSVRNetwork.h"
+#include "OSVRSession.h"
+
+static_assert(int(OSVRPoseSample::MAX_HANDLES) == int(OSVRPoseTable::CAPACITY), "recordings and streams carry every handle of the table");
+static_assert(int(OSVRSharedFrame::MAX_INTERFACES) == int(OSVRPoseTable::CAPACITY), "the shared frame mirrors every handle of the table");
+
+// the tracking state of one OSVR client context, without any thread of its own
+//
+// start() connects and waits for the display, then every update() runs one tick of the
+// poll loop: register new interfaces, update the context, read display and pose state and
+// publish a frame. OpenSourceVirtualReality drives one from a thread; single-threaded apps
+// can instantiate it with NullLockPolicy and call update() from their own loop.
+
+template <class LockPolicy, class StoragePolicy, class MathPolicy>
+class OSVRTrackingCore
+{
+public:
+	typedef uint32_t InterfaceHandle;
+	static const InterfaceHandle INVALID_INTERFACE = ~0u;
+
+	using Clock = OSVRClockMapper::Clock;
+	using Vec3 = typename MathPolicy::Vec3;
+	using Quat = typename MathPolicy::Quat;
+	using Matrix = typename MathPolicy::Matrix;
+	using Rect = typename MathPolicy::Rect;
+
+	// an empty host is the local server, otherwise the server on that host. server auto
+	// start only applies to the local one
+	OSVRTrackingCore(std::string applicationIdentifier, std::string host = "")
+		:app_identifier(applicationIdentifier)
+		,host(host)
+	{
+
+	}
+
+	~OSVRTrackingCore()
+	{
+		stop();
+	}
+
+	// connects to the server and waits for the display to start up, false if it never did
+	bool start(bool serverAutoStart = true, std::chrono::milliseconds timeout = std::chrono::seconds(5));
+	void stop();
+
+	// one tick of the poll loop
+	void update();
+
+	// returns the index of this interface in Frame::poses, adding a path twice returns the same handle
+	InterfaceHandle addInterface(std::string path);
+
+	bool getInterfacePose(const std::string& path, Vec3& translation, Quat& rotation);
+	// same as above, with the report time mapped onto std::chrono::steady_clock
+	bool getInterfacePose(const std::string& path, Vec3& translation, Quat& rotation, Clock::time_point& timestamp);
+	// handle lookups skip the path compare and never log, prefer them in per-frame code
+	bool getInterfacePose(InterfaceHandle handle, Vec3& translation, Quat& rotation);
+	bool getInterfacePose(InterfaceHandle handle, Vec3& translation, Quat& rotation, Clock::time_point& timestamp);
+
+	// velocity and acceleration reports next to the latest pose, calibrated like it. false
+	// while not registered, flags 0 for interfaces without them
+	bool getInterfaceDerivatives(InterfaceHandle handle, OSVRPoseDerivatives& derivatives) { return pose_table.readDerivatives(handle, derivatives); }
+
+	// the latest pose extrapolated to when from its report time, see OSVRPrediction.
+	// never further than MAX_PREDICTION seconds ahead and never backwards
+	bool getPredictedPose(InterfaceHandle handle, Clock::time_point when, Vec3& translation, Quat& rotation);
+	static constexpr double MAX_PREDICTION = 0.1;
+
+	// counts the fresh reports of an interface, 0 before the first one
+	uint64_t getGeneration(InterfaceHandle handle) const { return pose_table.getGeneration(handle); }
+
+	// blocks until the interface has a report newer than generation lastGeneration or the
+	// timeout passes, and returns its generation then (lastGeneration on a timeout). the
+	// new pose is already visible to getInterfacePose, the frame follows within the tick
+	uint64_t waitForNewPose(InterfaceHandle handle, uint64_t lastGeneration, Clock::duration timeout);
+
+	// smooths the poses of this interface on the poll thread from the next tick on, every
+	// consumer sees the filtered pose. params.enabled = false turns it off again
+	void setFilter(InterfaceHandle handle, const OSVRFilterParams& params);
+
+	// tracker to world transforms applied to every report after filtering, offsets are
+	// keyed by InterfaceHandle. every pose handed out is in world space from the tick after
+	// a change on, recordings keep the raw reports
+	OSVRCalibrationRegistry& getCalibration() { return calibration; }
+
+	// called on the poll thread for every fresh report, filtered and calibrated, right after
+	// it was published and before the frame of the tick. keep it short, it delays every
+	// interface behind it. the state is only valid during the call
+	using PoseCallback = OSVRDelegate<void(InterfaceHandle, const OSVR_PoseState&, const OSVR_TimeValue&)>;
+	typedef uint32_t SubscriptionId;
+	static const InterfaceHandle ANY_INTERFACE = INVALID_INTERFACE;
+
+	// lock-free, also from inside a callback. 0 when every subscription slot is taken
+	SubscriptionId subscribePose(InterfaceHandle handle, PoseCallback callback) { return pose_subscribers.add(handle, callback); }
+	// button reports of an interface, on the poll thread while the context updates
+	using ButtonCallback = OSVRDelegate<void(InterfaceHandle, const OSVR_ButtonReport&, const OSVR_TimeValue&)>;
+	SubscriptionId subscribeButton(InterfaceHandle handle, ButtonCallback callback) { return button_subscribers.add(handle, callback) | BUTTON_SUBSCRIPTION; }
+
+	// the callback is not running anymore once this returns, unless called from inside it
+	void unsubscribe(SubscriptionId id)
+	{
+		if (id & BUTTON_SUBSCRIPTION)
+			button_subscribers.remove(id & ~BUTTON_SUBSCRIPTION);
+		else
+			pose_subscribers.remove(id);
+	}
+
+	struct PoseEvent
+	{
+		OSVR_PoseState state; // filtered and calibrated
+		OSVR_TimeValue timestamp;
+	};
+
+	struct ButtonEvent
+	{
+		int32_t sensor;
+		OSVR_ButtonState state;
+		OSVR_TimeValue timestamp;
+	};
+
+	// parks a waiter until the next report of waiter->key, see OSVRWaitQueue. false for a
+	// key beyond the pose table. the building block of nextPose and nextButton
+	bool waitPose(OSVRWaiter<PoseEvent>* waiter) { return pose_wait_queue.push(waiter); }
+	bool waitButton(OSVRWaiter<ButtonEvent>* waiter) { return button_wait_queue.push(waiter); }
+	// before a parked waiter goes away, it is never touched once these return
+	void cancelPose(OSVRWaiter<PoseEvent>* waiter) { pose_wait_queue.cancel(waiter); }
+	void cancelButton(OSVRWaiter<ButtonEvent>* waiter) { button_wait_queue.cancel(waiter); }
+
+#ifdef OSVR_HAS_COROUTINES
+	// co_await tracker->nextPose(handle) resumes with the next fresh report of the interface
+	OSVRAwaitable<PoseEvent> nextPose(InterfaceHandle handle, OSVRExecutor executor = OSVRExecutor())
+	{
+		return OSVRAwaitable<PoseEvent>(&pose_wait_queue, handle, executor);
+	}
+
+	OSVRAwaitable<ButtonEvent> nextButton(InterfaceHandle handle, OSVRExecutor executor = OSVRExecutor())
+	{
+		return OSVRAwaitable<ButtonEvent>(&button_wait_queue, handle, executor);
+	}
+#endif
+
+	// any matrix of the core in the memory order of a Convention from OSVRMath.h. for
+	// conventions with the core's own memory order that's the matrix itself, upload it as is
+	template <class Convention>
+	static const float* getMatrix(const Matrix& m)
+	{
+		static_assert(Convention::transposed == false, "transposed conventions need the copying getMatrix");
+		return MathPolicy::getPtr(m);
+	}
+
+	template <class Convention>
+	static void getMatrix(const Matrix& m, float out[16])
+	{
+		Convention::copy(MathPolicy::getPtr(m), out);
+	}
+
+	typedef uint32_t RenderTarget;
+	static const RenderTarget INVALID_RENDER_TARGET = ~0u;
+	static const size_t MAX_RENDER_TARGETS = 4;
+
+	struct Surface
+	{
+		Matrix projection_matrix;
+		Rect viewport; // pixels of the display input, see pixel_viewports for a render target
+		int display_width = 0; // size of that display input
+		int display_height = 0;
+		// viewport scaled to each registered render target, indexed by RenderTarget. adjacent
+		// surfaces share their rounded edges so they tile the target without gaps
+		std::array<OSVRViewport, MAX_RENDER_TARGETS> pixel_viewports{};
+	};
+
+	struct Eye
+	{
+		Matrix modelview_matrix;
+		std::map<uint32_t, Surface> surfaces;
+	};
+
+	struct Viewer
+	{
+		std::map<uint32_t, Eye> eyes;
+	};
+
+	std::map<uint32_t, Viewer> getViewers();
+	// copies into a caller-owned tree, reusing its nodes so a warm tree is never reallocated
+	void getViewers(std::map<uint32_t, Viewer>& out);
+	// same, keyed by keyOffset + viewer id and leaving the keys of out outside
+	// [keyOffset, keyOffset + keyRange) alone, for front ends merging several cores
+	void getViewers(std::map<uint32_t, Viewer>& out, uint32_t keyOffset, uint32_t keyRange);
+	// same, with the eye matrices of the head pose predicted for when, see getPredictedPose
+	void getPredictedViewers(Clock::time_point when, std::map<uint32_t, Viewer>& out);
+
+	// eye matrices are computed locally from the HEAD_PATH pose, filtered and calibrated, and
+	// eye offsets cached from the display config at start. call this after the display
+	// config changed to cache them again on the next tick
+	void refreshDisplay() { has_pending_display = true; }
+	// metres between the first two eyes of a viewer, 0 before the display was cached
+	double getIpd(uint32_t viewer = 0);
+	static constexpr const char* HEAD_PATH = "/me/head";
+
+	// every surface of viewers as one std140 block, an OSVRCameraBlockHeader followed by an
+	// OSVRCameraData per surface in viewer, eye, surface order with viewports of target.
+	// returns the bytes the block needs and writes nothing when size is smaller
+	static size_t writeCameraBlock(const std::map<uint32_t, Viewer>& viewers, RenderTarget target, void* out, size_t size);
+
+	// render targets the surface viewports are kept in pixels for, recomputed when the
+	// display config or the size changes. INVALID_RENDER_TARGET when all are taken
+	RenderTarget addRenderTarget(int width, int height);
+	void setRenderTargetSize(RenderTarget target, int width, int height);
+	void removeRenderTarget(RenderTarget target);
+
+	struct InterfacePose
+	{
+		Vec3 translation;
+		Quat rotation;
+		Clock::time_point timestamp;
+		bool valid = false;
+		double filter_latency = 0.0; // seconds the filter currently trails the reports
+		uint64_t generation = 0; // see getGeneration
+		uint32_t derivative_flags = 0; // OSVRPoseDerivatives flags, the rates below are 0 when missing
+		Vec3 linear_velocity;
+		Vec3 angular_velocity;
+		Vec3 linear_acceleration;
+		Vec3 angular_acceleration;
+	};
+
+	// everything the poll thread produced in one tick
+	struct Frame
+	{
+		uint64_t tick = 0;
+		std::vector<InterfacePose> poses; // indexed by InterfaceHandle
+		std::vector<Matrix> model_matrices; // same, rotation and translation of each pose, identity before the first report
+		std::map<uint32_t, Viewer> viewers;
+	};
+
+	using FrameRef = typename OSVRFramePool<Frame>::Ref;
+
+	// latest complete frame, empty before the first tick. lock-free, the frame stays
+	// valid and unchanged for as long as the FrameRef is held
+	FrameRef captureFrame() { return frame_pool.acquire(); }
+
+	// OSVR report time in the local steady clock, see OSVRClockMapper
+	Clock::time_point toSteady(const OSVR_TimeValue& remote);
+	double getClockOffset();
+	double getClockDrift();
+
+	// mirrors every published frame into a named shared-memory segment for sibling
+	// processes, see OSVRSharedMemoryReader
+	bool enableSharedMemory(const std::string& name);
+	void disableSharedMemory();
+
+	// sends every published frame as one UDP datagram, see OSVRPoseReceiver
+	bool enableUdpPublisher(const std::string& host, uint16_t port, int keyframeInterval = 60);
+	void disableUdpPublisher();
+
+	// writes every pose report, not only the latest one per tick, to a session file,
+	// see OSVRSessionReader. precision is the position quantum in metres
+	bool enableRecording(const std::string& path, double precision = 0.001);
+	void disableRecording();
+
+protected:
+	struct InterfaceInfo
+	{
+		typename StoragePolicy::Path path;
+		osvr::clientkit::Interface interface;
+		InterfaceHandle handle = INVALID_INTERFACE;
+	};
+
+	// paths and client interfaces; pose state lives in pose_table
+	using Store = typename StoragePolicy::template Store<InterfaceInfo>;
+
+	const char* module = "OSVR";
+
+private:
+	void registerInterfaces();
+	void applyFilters();
+	void cacheDisplay();
+	void updateViewers();
+	void assignEyeMatrices(std::map<uint32_t, Viewer>& out, const float* matrices);
+	void assignEyeMatrix(std::map<uint32_t, Viewer>& out, size_t eye, const float* matrix);
+	double getIpdLocked(uint32_t viewer);
+	void updatePixelViewports();
+	bool predictState(InterfaceHandle handle, Clock::time_point when, OSVR_PoseState& state);
+	void updateInterfaces();
+	void publishFrame();
+	void publishPoolFrame(Frame& frame);
+	void updateModelMatrices(std::vector<Matrix>& matrices);
+	void publishSharedFrame();
+	void publishUdpFrame();
+	void recordReport(InterfaceHandle handle, const OSVR_TimeValue& timestamp, const OSVR_Pose3& pose);
+
+	void convertPose(const OSVR_PoseState& state, Vec3& translation, Quat& rotation);
+
+	// never allocates once the key exists
+	template <class K, class V>
+	static V& findOrInsert(std::map<K, V>& m, const typename std::map<K, V>::key_type& key)
+	{
+		auto it = m.find(key);
+		if (it == m.end())
+			it = m.emplace(key, V()).first;
+		return it->second;
+	}
+
+	// copies src into dst, reusing the nodes of every key both maps share. a plain map
+	// assignment is free to drop and reallocate the whole tree
+	template <class K, class V, class F>
+	static void assignMap(std::map<K, V>& dst, const std::map<K, V>& src, F assign)
+	{
+		auto d = dst.begin();
+		for (auto& s : src)
+		{
+			while (d != dst.end() && d->first < s.first)
+				d = dst.erase(d);
+			if (d == dst.end() || s.first < d->first)
+				d = dst.emplace_hint(d, s.first, V());
+			assign(d->second, s.second);
+			++d;
+		}
+		dst.erase(d, dst.end());
+	}
+
+	static void assignViewer(Viewer& dv, const Viewer& sv)
+	{
+		assignMap(dv.eyes, sv.eyes, [](Eye& de, const Eye& se)
+		{
+			de.modelview_matrix = se.modelview_matrix;
+			assignMap(de.surfaces, se.surfaces, [](Surface& ds, const Surface& ss)
+			{
+				ds = ss;
+			});
+		});
+	}
+
+	static void assignViewers(std::map<uint32_t, Viewer>& dst, const std::map<uint32_t, Viewer>& src)
+	{
+		assignMap(dst, src, assignViewer);
+	}
+
+	static void toSample(InterfaceHandle handle, const char* path, const OSVR_Pose3& pose, const OSVR_TimeValue& timestamp, OSVRPoseSample& sample);
+
+	static void poseCallback(void *userdata, const OSVR_TimeValue *timestamp, const OSVR_PoseReport *report);
+	static void buttonCallback(void *userdata, const OSVR_TimeValue *timestamp, const OSVR_ButtonReport *report);
+
+	// high bit of a button subscription id, pose ids never reach it
+	static const SubscriptionId BUTTON_SUBSCRIPTION = 0x80000000u;
+
+	// runs between polling the pose table and publishing it
+	struct IngestStage : OSVRPoseTable::Stage
+	{
+		OSVRTrackingCore* core;
+
+		IngestStage(OSVRTrackingCore* core) :core(core) {}
+
+		void process(uint32_t first, uint64_t mask, uint64_t fresh, OSVR_PoseState* states, OSVRPoseDerivatives* derivatives, const OSVR_TimeValue* timestamps) override
+		{
+			core->filters.apply(first, mask, fresh, states, timestamps);
+			if (core->active_calibration)
+				core->active_calibration->apply(first, mask, states, derivatives);
+		}
+
+		void published(uint32_t first, uint64_t fresh, const OSVR_PoseState* states, const OSVR_TimeValue* timestamps) override
+		{
+			auto& subscribers = core->pose_subscribers;
+			auto& waiters = core->pose_wait_queue;
+			subscribers.beginDispatch();
+			for (uint32_t i = 0; i < OSVRPoseTable::SHARD_SIZE; i++)
+			{
+				if ((fresh & (uint64_t(1) << i)) == 0)
+					continue;
+				subscribers.dispatch(first + i, first + i, states[i], timestamps[i]);
+				if (waiters.isWaiting())
+					waiters.wake(first + i, PoseEvent{ states[i], timestamps[i] });
+			}
+			subscribers.endDispatch();
+		}
+	};
+
+	// userdata of the pose callbacks, a deque so registered pointers never move
+	struct CallbackTarget
+	{
+		OSVRTrackingCore* core;
+		InterfaceHandle handle;
+	};
+
+	LockPolicy lock;
+	std::string app_identifier = "";
+	std::string host = "";
+	bool server_auto_started = false;
+
+	std::unique_ptr<osvr::clientkit::ClientContext> ctx;
+	std::unique_ptr<osvr::clientkit::DisplayConfig> display;
+
+	std::deque<std::string> interface_paths;
+	std::atomic<bool> has_pending_interfaces{ false };
+	std::vector<std::string> handle_paths;
+	Store interface_infos;
+	OSVRPoseTable pose_table;
+	std::vector<uint32_t> lost_handles;
+	IngestStage ingest_stage{ this };
+	OSVRPoseFilterBank filters; // poll thread only
+	std::vector<std::pair<InterfaceHandle, OSVRFilterParams>> pending_filters;
+	std::atomic<bool> has_pending_filters{ false };
+	OSVRCalibrationRegistry calibration;
+	OSVRCalibrationRegistry::Ref active_calibration; // poll thread only
+	OSVRSubscribers<PoseCallback> pose_subscribers;
+	OSVRSubscribers<ButtonCallback> button_subscribers;
+	OSVRWaitQueue<PoseEvent> pose_wait_queue{ OSVRPoseTable::CAPACITY };
+	OSVRWaitQueue<ButtonEvent> button_wait_queue{ OSVRPoseTable::CAPACITY };
+	std::mutex pose_wait_mutex;
+	std::condition_variable pose_wait;
+	std::atomic<int> pose_waiters{ 0 };
+	std::map<uint32_t, Viewer> viewers;
+
+	// eye cache, written by the poll thread under lock.exclusive
+	struct CachedEye
+	{
+		uint32_t viewer_id;
+		uint32_t eye_id;
+	};
+	std::vector<CachedEye> eyes;
+	std::vector<OSVR_Pose3> eye_offsets; // same order, eye pose in head space
+	std::vector<float> eye_matrices; // poll thread only
+	std::atomic<bool> has_pending_display{ false };
+	InterfaceHandle head_handle = INVALID_INTERFACE;
+
+	struct RenderTargetSize
+	{
+		bool used = false;
+		int width = 0;
+		int height = 0;
+	};
+	std::array<RenderTargetSize, MAX_RENDER_TARGETS> render_targets; // under lock.exclusive
+	OSVRClockMapper clock_mapper;
+	OSVRFramePool<Frame> frame_pool;
+	uint64_t tick = 0;
+	OSVRSharedMemoryWriter shared_memory;
+	OSVRPosePublisher udp_publisher;
+	std::vector<OSVRPoseSample> udp_samples;
+	std::deque<CallbackTarget> callback_targets;
+	OSVRSessionWriter recorder;
+};
+
+template <class L, class S, class M>
+bool OSVRTrackingCore<L, S, M>::start(bool serverAutoStart, std::chrono::milliseconds timeout)
+{
+	if (serverAutoStart && host.empty())
+	{
+		OSVRLog::notice(module, "client attempt server auto start");
+		osvrClientAttemptServerAutoStart();
+		server_auto_started = true;
+	}
+
+	if (host.empty())
+		ctx.reset(new osvr::clientkit::ClientContext(app_identifier.c_str(), 0));
+	else
+		ctx.reset(new osvr::clientkit::ClientContext(osvrClientInitHost(app_identifier.c_str(), host.c_str(), 0)));
+	display.reset(new osvr::clientkit::DisplayConfig(*ctx));
+
+	// check display valid
+	if (display->valid() == false) {
+		OSVRLog::error(module, "Could not get display config (server probably not running or not behaving), exiting.");
+		return false;
+	}
+
+	// check display startup
+	OSVRLog::notice(module, "display check startup");
+	auto check_timestamp = Clock::now();
+	while (display->checkStartup() == false) {
+		ctx->update();
+		auto dt = Clock::now() - check_timestamp;
+		if (dt > timeout)
+		{
+			OSVRLog::warning(module, "display check time out");
+			return false;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+	OSVRLog::notice(module, "display startup status is good");
+	head_handle = addInterface(HEAD_PATH);
+	has_pending_display = true;
+	return true;
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::stop()
+{
+	display.reset();
+	ctx.reset();
+	if (server_auto_started)
+	{
+		osvrClientReleaseAutoStartedServer();
+		server_auto_started = false;
+	}
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::update()
+{
+	if (ctx == nullptr)
+		return;
+
+	registerInterfaces();
+	applyFilters();
+	button_wait_queue.collect();
+	ctx->update();
+	updateInterfaces();
+	updateViewers();
+
+	lock.exclusive([&]
+	{
+		publishFrame();
+	});
+}
+
+template <class L, class S, class M>
+typename OSVRTrackingCore<L, S, M>::InterfaceHandle OSVRTrackingCore<L, S, M>::addInterface(std::string path)
+{
+	InterfaceHandle handle = INVALID_INTERFACE;
+	lock.exclusive([&]
+	{
+		for (InterfaceHandle i = 0; i < handle_paths.size(); i++)
+		{
+			if (handle_paths[i] == path)
+			{
+				handle = i;
+				return;
+			}
+		}
+		handle_paths.push_back(path);
+		interface_paths.push_back(path);
+		handle = InterfaceHandle(handle_paths.size() - 1);
+		has_pending_interfaces = true;
+	});
+	return handle;
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::registerInterfaces()
+{
+	if (has_pending_interfaces.exchange(false) == false)
+		return;
+
+	lock.write([&]
+	{
+		for (auto& path : interface_paths)
+		{
+			OSVRLog::notice(module, "interface add: %s", path.c_str());
+			auto handle = InterfaceHandle(std::find(handle_paths.begin(), handle_paths.end(), path) - handle_paths.begin());
+			InterfaceInfo* info = interface_infos.insert(handle, path);
+			if (info == nullptr)
+			{
+				OSVRLog::error(module, "interface storage is full or the path too long, dropping: %s", path.c_str());
+				continue;
+			}
+			info->interface = ctx->getInterface(path);
+			info->handle = handle;
+			if (pose_table.insert(handle, info->interface.get()) == false)
+				OSVRLog::error(module, "pose table is full, no state for: %s", path.c_str());
+
+			callback_targets.push_back({ this, handle });
+			osvrRegisterPoseCallback(info->interface.get(), poseCallback, &callback_targets.back());
+			osvrRegisterButtonCallback(info->interface.get(), buttonCallback, &callback_targets.back());
+			recorder.addInterface(handle, path);
+		}
+		interface_paths.clear();
+		// every interface can lose its state in one tick, poll must not grow it then
+		lost_handles.reserve(handle_paths.size());
+	});
+}
+
+template <class L, class S, class M>
+uint64_t OSVRTrackingCore<L, S, M>::waitForNewPose(InterfaceHandle handle, uint64_t lastGeneration, Clock::duration timeout)
+{
+	uint64_t generation = pose_table.getGeneration(handle);
+	if (generation != lastGeneration)
+		return generation;
+
+	auto deadline = Clock::now() + timeout;
+	pose_waiters.fetch_add(1);
+	{
+		std::unique_lock<std::mutex> guard(pose_wait_mutex);
+		pose_wait.wait_until(guard, deadline, [&]
+		{
+			generation = pose_table.getGeneration(handle);
+			return generation != lastGeneration;
+		});
+	}
+	pose_waiters.fetch_sub(1);
+	return generation;
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::setFilter(InterfaceHandle handle, const OSVRFilterParams& params)
+{
+	if (handle >= OSVRPoseTable::CAPACITY)
+		return;
+	lock.exclusive([&]
+	{
+		pending_filters.emplace_back(handle, params);
+		has_pending_filters = true;
+	});
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::applyFilters()
+{
+	if (has_pending_filters.exchange(false) == false)
+		return;
+
+	lock.exclusive([&]
+	{
+		for (auto& p : pending_filters)
+			filters.setParams(p.first, p.second);
+		pending_filters.clear();
+	});
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::cacheDisplay()
+{
+	// the only walk over the display config, viewports, projections and eye offsets stay
+	// fixed until the config changes
+	lock.exclusive([&]
+	{
+		viewers.clear();
+		eyes.clear();
+		eye_offsets.clear();
+		for (uint32_t i = 0; i < display->getNumViewers(); i++)
+		{
+			auto viewer = display->getViewer(i);
+			auto viewer_id = viewer.getViewerID();
+			auto& curr_viewer = findOrInsert(viewers, viewer_id);
+			// offsets are eye poses relative to the head, without a head pose an absolute eye
+			// pose would end up as the offset. the eyes sit at the head then
+			OSVR_Pose3 head;
+			bool has_head = viewer.getPose(head);
+			if (has_head == false)
+			{
+				head = OSVRCalibration::identity();
+				OSVRLog::warning(module, "no pose for viewer %u, its eyes use identity offsets", unsigned(viewer_id));
+			}
+
+			for (uint32_t j = 0; j < viewer.getNumEyes(); j++)
+			{
+				auto eye = viewer.getEye(j);
+				auto eye_id = eye.getEyeID();
+				auto& curr_eye = findOrInsert(curr_viewer.eyes, eye_id);
+
+				OSVR_Pose3 eye_pose;
+				if (has_head == false || eye.getPose(eye_pose) == false)
+					eye_pose = head;
+				eyes.push_back({ viewer_id, eye_id });
+				eye_offsets.push_back(OSVREyes::toOffset(head, eye_pose));
+
+				for (uint32_t k = 0; k < eye.getNumSurfaces(); k++)
+				{
+					auto surface = eye.getSurface(k);
+					auto surface_id = surface.getSurfaceID();
+					auto& curr_surface = findOrInsert(curr_eye.surfaces, surface_id);
+
+					auto viewport = surface.getRelativeViewport();
+					M::setRect(curr_surface.viewport, viewport.left, viewport.bottom, viewport.width, viewport.height);
+					auto dimensions = display->getDisplayDimensions(surface.getDisplayInputIndex());
+					curr_surface.display_width = dimensions.width;
+					curr_surface.display_height = dimensions.height;
+
+					float z_near = 0.01;
+					float z_far = 500;
+					OSVR_MatrixConventions proj_flag = OSVR_MATRIX_ROWMAJOR | OSVR_MATRIX_ROWVECTORS | OSVR_MATRIX_SIGNEDZ | OSVR_MATRIX_RHINPUT;
+					surface.getProjectionMatrix(z_near, z_far, proj_flag, M::getPtr(curr_surface.projection_matrix));
+				}
+			}
+		}
+		eye_matrices.resize(eyes.size() * 16);
+		updatePixelViewports();
+		OSVRLog::notice(module, "display cached: %d eyes, ipd %.1f mm", int(eyes.size()), getIpdLocked(0) * 1000.0);
+	});
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::updateViewers()
+{
+	if (has_pending_display.exchange(false))
+		cacheDisplay();
+
+	// the poll thread is the only writer of the eye cache, only publishing the matrices
+	// needs the lock
+	OSVR_PoseState head;
+	OSVR_TimeValue timestamp;
+	if (pose_table.read(head_handle, head, timestamp) == false)
+		head = OSVRCalibration::identity();
+	OSVREyes::toViewMatrices(head, eye_offsets.data(), eye_offsets.size(), eye_matrices.data());
+
+	lock.exclusive([&]
+	{
+		assignEyeMatrices(viewers, eye_matrices.data());
+	});
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::assignEyeMatrices(std::map<uint32_t, Viewer>& out, const float* matrices)
+{
+	for (size_t i = 0; i < eyes.size(); i++)
+		assignEyeMatrix(out, i, matrices + i * 16);
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::assignEyeMatrix(std::map<uint32_t, Viewer>& out, size_t i, const float* matrix)
+{
+	auto viewer = out.find(eyes[i].viewer_id);
+	if (viewer == out.end())
+		return;
+	auto eye = viewer->second.eyes.find(eyes[i].eye_id);
+	if (eye != viewer->second.eyes.end())
+		std::memcpy(M::getPtr(eye->second.modelview_matrix), matrix, 16 * sizeof(float));
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::updatePixelViewports()
+{
+	// round the edges rather than origin and size, so surfaces next to each other
+	// meet on the same pixel
+	auto scale = [](float v, int from, int to) { return from > 0 ? int(std::lround(double(v) * to / from)) : 0; };
+
+	for (auto& viewer : viewers)
+	{
+		for (auto& eye : viewer.second.eyes)
+		{
+			for (auto& sf : eye.second.surfaces)
+			{
+				Surface& surface = sf.second;
+				float rect[4];
+				M::getRect(surface.viewport, rect);
+				for (size_t t = 0; t < MAX_RENDER_TARGETS; t++)
+				{
+					OSVRViewport& out = surface.pixel_viewports[t];
+					const RenderTargetSize& target = render_targets[t];
+					if (target.used == false)
+					{
+						out = OSVRViewport{ 0, 0, 0, 0 };
+						continue;
+					}
+					int left = scale(rect[0], surface.display_width, target.width);
+					int bottom = scale(rect[1], surface.display_height, target.height);
+					int right = scale(rect[0] + rect[2], surface.display_width, target.width);
+					int top = scale(rect[1] + rect[3], surface.display_height, target.height);
+					out = OSVRViewport{ left, bottom, right - left, top - bottom };
+				}
+			}
+		}
+	}
+}
+
+template <class L, class S, class M>
+size_t OSVRTrackingCore<L, S, M>::writeCameraBlock(const std::map<uint32_t, Viewer>& viewers, RenderTarget target, void* out, size_t size)
+{
+	size_t count = 0;
+	for (auto& viewer : viewers)
+	{
+		for (auto& eye : viewer.second.eyes)
+			count += eye.second.surfaces.size();
+	}
+	size_t needed = OSVRCameraBlock::getSize(count);
+	if (size < needed)
+		return needed;
+
+	auto header = static_cast<OSVRCameraBlockHeader*>(out);
+	*header = OSVRCameraBlockHeader{ { uint32_t(count), 0, 0, 0 } };
+	auto camera = reinterpret_cast<OSVRCameraData*>(header + 1);
+	OSVRViewport none{ 0, 0, 0, 0 };
+	for (auto& viewer : viewers)
+	{
+		for (auto& eye : viewer.second.eyes)
+		{
+			for (auto& sf : eye.second.surfaces)
+			{
+				const Surface& surface = sf.second;
+				const OSVRViewport& viewport = target < MAX_RENDER_TARGETS ? surface.pixel_viewports[target] : none;
+				OSVRCameraBlock::fill(*camera++, M::getPtr(eye.second.modelview_matrix), M::getPtr(surface.projection_matrix), viewport, viewer.first, eye.first, sf.first);
+			}
+		}
+	}
+	return needed;
+}
+
+template <class L, class S, class M>
+typename OSVRTrackingCore<L, S, M>::RenderTarget OSVRTrackingCore<L, S, M>::addRenderTarget(int width, int height)
+{
+	RenderTarget target = INVALID_RENDER_TARGET;
+	lock.exclusive([&]
+	{
+		for (size_t t = 0; t < MAX_RENDER_TARGETS; t++)
+		{
+			if (render_targets[t].used == false)
+			{
+				render_targets[t] = RenderTargetSize{ true, width, height };
+				target = RenderTarget(t);
+				updatePixelViewports();
+				return;
+			}
+		}
+		OSVRLog::warning(module, "no render target left for %d x %d", width, height);
+	});
+	return target;
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::setRenderTargetSize(RenderTarget target, int width, int height)
+{
+	if (target >= MAX_RENDER_TARGETS)
+		return;
+	lock.exclusive([&]
+	{
+		RenderTargetSize& size = render_targets[target];
+		if (size.used == false || (size.width == width && size.height == height))
+			return;
+		size.width = width;
+		size.height = height;
+		updatePixelViewports();
+	});
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::removeRenderTarget(RenderTarget target)
+{
+	if (target >= MAX_RENDER_TARGETS)
+		return;
+	lock.exclusive([&]
+	{
+		render_targets[target] = RenderTargetSize();
+		updatePixelViewports();
+	});
+}
+
+template <class L, class S, class M>
+double OSVRTrackingCore<L, S, M>::getIpdLocked(uint32_t viewer)
+{
+	// distance between the first two eyes of the viewer
+	const OSVR_Pose3* first = nullptr;
+	for (size_t i = 0; i < eyes.size(); i++)
+	{
+		if (eyes[i].viewer_id != viewer)
+			continue;
+		if (first == nullptr)
+		{
+			first = &eye_offsets[i];
+			continue;
+		}
+		double d = 0.0;
+		for (int k = 0; k < 3; k++)
+			d += (eye_offsets[i].translation.data[k] - first->translation.data[k]) * (eye_offsets[i].translation.data[k] - first->translation.data[k]);
+		return std::sqrt(d);
+	}
+	return 0.0;
+}
+
+template <class L, class S, class M>
+double OSVRTrackingCore<L, S, M>::getIpd(uint32_t viewer)
+{
+	double ipd = 0.0;
+	lock.exclusive([&] { ipd = getIpdLocked(viewer); });
+	return ipd;
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::getPredictedViewers(Clock::time_point when, std::map<uint32_t, Viewer>& out)
+{
+	OSVR_PoseState head;
+	if (predictState(head_handle, when, head) == false)
+		head = OSVRCalibration::identity();
+
+	// an eye at a time straight into out, a warm tree costs no allocation
+	lock.exclusive([&]
+	{
+		assignViewers(out, viewers);
+		for (size_t i = 0; i < eyes.size(); i++)
+		{
+			float matrix[16];
+			OSVREyes::toViewMatrices(head, &eye_offsets[i], 1, matrix);
+			assignEyeMatrix(out, i, matrix);
+		}
+	});
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::updateInterfaces()
+{
+	auto now = Clock::now();
+	OSVR_TimeValue newest;
+
+	// a new calibration applies to repeated reports too, stationary interfaces may not
+	// report again for a while
+	auto calibration_ref = calibration.get();
+	bool recalibrated = calibration_ref != active_calibration;
+	active_calibration = calibration_ref;
+
+	bool waiting = pose_wait_queue.collect();
+	bool staged = filters.isActive() || (active_calibration && active_calibration->isIdentity() == false) || pose_subscribers.empty() == false || waiting;
+	bool fresh = pose_table.poll(newest, lost_handles, staged ? &ingest_stage : nullptr, recalibrated);
+
+	if (fresh)
+	{
+		// only fresh reports say anything about transport delay, and the newest of them
+		// bounds it tightest
+		lock.write([&]
+		{
+			clock_mapper.addSample(newest, now);
+		});
+	}
+
+	// after the generations were bumped, sequentially consistent like them. taking the
+	// mutex closes the gap between a waiter's check and its wait
+	if (fresh && pose_waiters.load() > 0)
+	{
+		{
+			std::lock_guard<std::mutex> guard(pose_wait_mutex);
+		}
+		pose_wait.notify_all();
+	}
+
+	if (lost_handles.empty() == false)
+	{
+		lock.exclusive([&]
+		{
+			for (auto handle : lost_handles)
+				OSVRLog::warning(module, "no pose state: %s", handle_paths[handle].c_str());
+		});
+	}
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::publishFrame()
+{
+	++tick;
+	Frame* frame = frame_pool.beginWrite();
+	if (frame != nullptr)
+		publishPoolFrame(*frame);
+	// else every spare frame is still held by a reader and the pool misses this tick, the
+	// other outputs don't depend on it
+
+	if (shared_memory.isOpen())
+		publishSharedFrame();
+	if (udp_publisher.isOpen())
+		publishUdpFrame();
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::publishPoolFrame(Frame& frame)
+{
+	frame.tick = tick;
+	frame.poses.resize(handle_paths.size());
+	// pooled frames are reused, nothing of an older tick may survive into this one
+	for (auto& pose : frame.poses)
+	{
+		pose.timestamp = Clock::time_point();
+		pose.valid = false;
+		pose.filter_latency = 0.0;
+		pose.generation = 0;
+		pose.derivative_flags = 0;
+		M::setVec3(pose.linear_velocity, 0, 0, 0);
+		M::setVec3(pose.angular_velocity, 0, 0, 0);
+		M::setVec3(pose.linear_acceleration, 0, 0, 0);
+		M::setVec3(pose.angular_acceleration, 0, 0, 0);
+	}
+
+	OSVR_PoseState state;
+	OSVR_TimeValue timestamp;
+	for (InterfaceHandle handle = 0; handle < frame.poses.size(); handle++)
+	{
+		if (pose_table.read(handle, state, timestamp) == false)
+			continue;
+		auto& pose = frame.poses[handle];
+		convertPose(state, pose.translation, pose.rotation);
+		pose.timestamp = clock_mapper.toSteady(timestamp);
+		pose.valid = timestamp.seconds != 0 || timestamp.microseconds != 0;
+		pose.filter_latency = filters.getLatency(handle);
+		pose.generation = pose_table.getGeneration(handle);
+
+		OSVRPoseDerivatives derivatives;
+		if (pose_table.readDerivatives(handle, derivatives))
+		{
+			auto& d = derivatives;
+			pose.derivative_flags = d.flags;
+			M::setVec3(pose.linear_velocity, d.linear_velocity[0], d.linear_velocity[1], d.linear_velocity[2]);
+			M::setVec3(pose.angular_velocity, d.angular_velocity[0], d.angular_velocity[1], d.angular_velocity[2]);
+			M::setVec3(pose.linear_acceleration, d.linear_acceleration[0], d.linear_acceleration[1], d.linear_acceleration[2]);
+			M::setVec3(pose.angular_acceleration, d.angular_acceleration[0], d.angular_acceleration[1], d.angular_acceleration[2]);
+		}
+	}
+
+	updateModelMatrices(frame.model_matrices);
+	assignViewers(frame.viewers, viewers);
+	frame_pool.publish();
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::updateModelMatrices(std::vector<Matrix>& matrices)
+{
+	static_assert(sizeof(Matrix) == 16 * sizeof(float), "the batch conversion writes 16 packed floats per matrix");
+	static const float identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+	// the poll thread is the only writer of the pose table, its columns are read directly
+	// and converted a shard at a time
+	matrices.resize(handle_paths.size());
+	for (size_t base = 0; base < matrices.size(); base += OSVRPoseTable::SHARD_SIZE)
+	{
+		size_t count = std::min<size_t>(OSVRPoseTable::SHARD_SIZE, matrices.size() - base);
+		const OSVRPoseTable::Shard* shard = pose_table.getShard(uint32_t(base));
+		if (shard == nullptr)
+		{
+			for (size_t i = 0; i < count; i++)
+				std::memcpy(M::getPtr(matrices[base + i]), identity, sizeof(identity));
+			continue;
+		}
+
+		OSVRPoseColumns columns = {
+			{ shard->translation[0], shard->translation[1], shard->translation[2] },
+			{ shard->rotation[0], shard->rotation[1], shard->rotation[2], shard->rotation[3] }
+		};
+		OSVRPoseBatch::toMatrices(columns, count, M::getPtr(matrices[base]));
+	}
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::publishSharedFrame()
+{
+	OSVRSharedFrame* shared = shared_memory.beginWrite();
+	shared->tick = tick;
+	shared->num_interfaces = uint32_t(std::min<size_t>(handle_paths.size(), OSVRSharedFrame::MAX_INTERFACES));
+	for (uint32_t i = 0; i < shared->num_interfaces; i++)
+	{
+		auto& face = shared->interfaces[i];
+		OSVRSharedFrame::setPath(face, handle_paths[i]);
+		face.valid = 0;
+	}
+
+	OSVR_PoseState state;
+	OSVR_TimeValue timestamp;
+	for (uint32_t handle = 0; handle < shared->num_interfaces; handle++)
+	{
+		if (pose_table.read(handle, state, timestamp) == false)
+			continue;
+		auto& face = shared->interfaces[handle];
+		for (int i = 0; i < 3; i++)
+			face.translation[i] = float(state.translation.data[i]);
+		face.rotation[0] = float(osvrQuatGetX(&(state.rotation)));
+		face.rotation[1] = float(osvrQuatGetY(&(state.rotation)));
+		face.rotation[2] = float(osvrQuatGetZ(&(state.rotation)));
+		face.rotation[3] = float(osvrQuatGetW(&(state.rotation)));
+		face.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(clock_mapper.toSteady(timestamp).time_since_epoch()).count();
+		face.osvr_seconds = timestamp.seconds;
+		face.osvr_microseconds = timestamp.microseconds;
+		face.valid = timestamp.seconds != 0 || timestamp.microseconds != 0;
+	}
+
+	uint32_t num_eyes = 0;
+	for (auto& vi : viewers)
+	{
+		for (auto& e : vi.second.eyes)
+		{
+			if (num_eyes == OSVRSharedFrame::MAX_EYES)
+				break;
+			auto& eye = shared->eyes[num_eyes++];
+			eye.viewer_id = vi.first;
+			eye.eye_id = e.first;
+			std::memcpy(eye.modelview_matrix, M::getPtr(e.second.modelview_matrix), sizeof(eye.modelview_matrix));
+			eye.num_surfaces = 0;
+			for (auto& sf : e.second.surfaces)
+			{
+				if (eye.num_surfaces == OSVRSharedFrame::MAX_SURFACES)
+					break;
+				auto& surface = eye.surfaces[eye.num_surfaces++];
+				surface.surface_id = sf.first;
+				std::memcpy(surface.projection_matrix, M::getPtr(sf.second.projection_matrix), sizeof(surface.projection_matrix));
+				M::getRect(sf.second.viewport, surface.viewport);
+			}
+		}
+	}
+	shared->num_eyes = num_eyes;
+
+	shared_memory.endWrite();
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::publishUdpFrame()
+{
+	// reuses the sample buffer, only grows with new interfaces
+	udp_samples.clear();
+	interface_infos.forEach([&](const InterfaceInfo& info)
+	{
+		OSVR_PoseState state;
+		OSVR_TimeValue timestamp;
+		if (pose_table.read(info.handle, state, timestamp) == false)
+			return;
+		OSVRPoseSample sample;
+		toSample(info.handle, info.path.c_str(), state, timestamp, sample);
+		udp_samples.push_back(sample);
+	});
+	udp_publisher.send(udp_samples.data(), udp_samples.size());
+}
+
+template <class L, class S, class M>
+bool OSVRTrackingCore<L, S, M>::enableSharedMemory(const std::string& name)
+{
+	bool opened = false;
+	lock.exclusive([&]
+	{
+		opened = shared_memory.open(name);
+	});
+	if (opened)
+		OSVRLog::notice(module, "publishing frames to shared memory: %s", name.c_str());
+	else
+		OSVRLog::error(module, "could not open shared memory: %s", name.c_str());
+	return opened;
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::disableSharedMemory()
+{
+	lock.exclusive([&]
+	{
+		shared_memory.close();
+	});
+}
+
+template <class L, class S, class M>
+bool OSVRTrackingCore<L, S, M>::enableUdpPublisher(const std::string& host, uint16_t port, int keyframeInterval)
+{
+	bool opened = false;
+	lock.exclusive([&]
+	{
+		opened = udp_publisher.open(host, port, keyframeInterval);
+	});
+	return opened;
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::disableUdpPublisher()
+{
+	lock.exclusive([&]
+	{
+		udp_publisher.close();
+	});
+}
+
+template <class L, class S, class M>
+bool OSVRTrackingCore<L, S, M>::enableRecording(const std::string& path, double precision)
+{
+	// the recorder guards itself, the lock only covers the interface list
+	if (recorder.open(path, precision) == false)
+		return false;
+	lock.exclusive([&]
+	{
+		interface_infos.forEach([&](const InterfaceInfo& info)
+		{
+			recorder.addInterface(info.handle, info.path.c_str());
+		});
+	});
+	return true;
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::disableRecording()
+{
+	recorder.close();
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::recordReport(InterfaceHandle handle, const OSVR_TimeValue& timestamp, const OSVR_Pose3& pose)
+{
+	// poll thread. only queues the sample, coding and I/O happen on the recorder's thread
+	if (recorder.isOpen() == false)
+		return;
+	OSVRPoseSample sample;
+	toSample(handle, nullptr, pose, timestamp, sample);
+	recorder.write(sample);
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::toSample(InterfaceHandle handle, const char* path, const OSVR_Pose3& pose, const OSVR_TimeValue& timestamp, OSVRPoseSample& sample)
+{
+	sample.handle = handle;
+	sample.path = path;
+	for (int i = 0; i < 3; i++)
+		sample.translation[i] = float(pose.translation.data[i]);
+	sample.rotation[0] = float(osvrQuatGetX(&(pose.rotation)));
+	sample.rotation[1] = float(osvrQuatGetY(&(pose.rotation)));
+	sample.rotation[2] = float(osvrQuatGetZ(&(pose.rotation)));
+	sample.rotation[3] = float(osvrQuatGetW(&(pose.rotation)));
+	sample.timestamp = int64_t(timestamp.seconds) * 1000000 + timestamp.microseconds;
+	sample.valid = timestamp.seconds != 0 || timestamp.microseconds != 0;
+}
+
+template <class L, class S, class M>
+bool OSVRTrackingCore<L, S, M>::getInterfacePose(const std::string& path, Vec3& translation, Quat& rotation)
+{
+	Clock::time_point timestamp;
+	return getInterfacePose(path, translation, rotation, timestamp);
+}
+
+template <class L, class S, class M>
+bool OSVRTrackingCore<L, S, M>::getInterfacePose(const std::string& path, Vec3& translation, Quat& rotation, Clock::time_point& timestamp)
+{
+	InterfaceHandle handle = INVALID_INTERFACE;
+	lock.exclusive([&]
+	{
+		InterfaceInfo* info = interface_infos.find(path);
+		if (info != nullptr)
+			handle = info->handle;
+	});
+
+	if (handle == INVALID_INTERFACE)
+	{
+		OSVRLog::warning(module, "interface is not found with path: %s", path.c_str());
+		return false;
+	}
+
+	return getInterfacePose(handle, translation, rotation, timestamp);
+}
+
+template <class L, class S, class M>
+bool OSVRTrackingCore<L, S, M>::getInterfacePose(InterfaceHandle handle, Vec3& translation, Quat& rotation)
+{
+	Clock::time_point timestamp;
+	return getInterfacePose(handle, translation, rotation, timestamp);
+}
+
+template <class L, class S, class M>
+bool OSVRTrackingCore<L, S, M>::getInterfacePose(InterfaceHandle handle, Vec3& translation, Quat& rotation, Clock::time_point& timestamp)
+{
+	OSVR_PoseState state;
+	OSVR_TimeValue report_time;
+	// false while not registered by the poll thread yet
+	if (pose_table.read(handle, state, report_time) == false)
+		return false;
+
+	convertPose(state, translation, rotation);
+	timestamp = toSteady(report_time);
+	return true;
+}
+
+template <class L, class S, class M>
+bool OSVRTrackingCore<L, S, M>::getPredictedPose(InterfaceHandle handle, Clock::time_point when, Vec3& translation, Quat& rotation)
+{
+	OSVR_PoseState state;
+	if (predictState(handle, when, state) == false)
+		return false;
+	convertPose(state, translation, rotation);
+	return true;
+}
+
+template <class L, class S, class M>
+bool OSVRTrackingCore<L, S, M>::predictState(InterfaceHandle handle, Clock::time_point when, OSVR_PoseState& state)
+{
+	OSVR_TimeValue report_time;
+	OSVRPoseDerivatives derivatives;
+	if (pose_table.read(handle, state, report_time) == false || pose_table.readDerivatives(handle, derivatives) == false)
+		return false;
+
+	double dt = std::chrono::duration<double>(when - toSteady(report_time)).count();
+	OSVRPrediction::extrapolate(state, derivatives, std::max(0.0, std::min(dt, double(MAX_PREDICTION))), state);
+	return true;
+}
+
+template <class L, class S, class M>
+std::map<uint32_t, typename OSVRTrackingCore<L, S, M>::Viewer> OSVRTrackingCore<L, S, M>::getViewers()
+{
+	std::map<uint32_t, Viewer> out;
+	getViewers(out);
+	return out;
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::getViewers(std::map<uint32_t, Viewer>& out)
+{
+	lock.exclusive([&]
+	{
+		assignViewers(out, viewers);
+	});
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::getViewers(std::map<uint32_t, Viewer>& out, uint32_t keyOffset, uint32_t keyRange)
+{
+	uint64_t end = uint64_t(keyOffset) + keyRange;
+	lock.exclusive([&]
+	{
+		// assignMap over the key range only, existing nodes are updated in place
+		auto d = out.lower_bound(keyOffset);
+		for (auto& s : viewers)
+		{
+			if (s.first >= keyRange)
+				break;
+			uint32_t key = keyOffset + s.first;
+			while (d != out.end() && d->first < key)
+				d = out.erase(d);
+			if (d == out.end() || key < d->first)
+				d = out.emplace_hint(d, key, Viewer());
+			assignViewer(d->second, s.second);
+			++d;
+		}
+		while (d != out.end() && d->first < end)
+			d = out.erase(d);
+	});
+}
+
+template <class L, class S, class M>
+typename OSVRTrackingCore<L, S, M>::Clock::time_point OSVRTrackingCore<L, S, M>::toSteady(const OSVR_TimeValue& remote)
+{
+	Clock::time_point result;
+	lock.read([&] { result = clock_mapper.toSteady(remote); });
+	return result;
+}
+
+template <class L, class S, class M>
+double OSVRTrackingCore<L, S, M>::getClockOffset()
+{
+	double result = 0.0;
+	lock.read([&] { result = clock_mapper.getOffset(); });
+	return result;
+}
+
+template <class L, class S, class M>
+double OSVRTrackingCore<L, S, M>::getClockDrift()
+{
+	double result = 0.0;
+	lock.read([&] { result = clock_mapper.getDrift(); });
+	return result;
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::convertPose(const OSVR_PoseState& state, Vec3& translation, Quat& rotation)
+{
+	double x, y, z, w;
+
+	x = state.translation.data[0];
+	y = state.translation.data[1];
+	z = state.translation.data[2];
+	M::setVec3(translation, x, y, z);
+
+	x = osvrQuatGetX(&(state.rotation));
+	y = osvrQuatGetY(&(state.rotation));
+	z = osvrQuatGetZ(&(state.rotation));
+	w = osvrQuatGetW(&(state.rotation));
+	M::setQuat(rotation, x, y, z, w);
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::poseCallback(void *userdata, const OSVR_TimeValue *timestamp, const OSVR_PoseReport *report)
+{
+	auto target = static_cast<CallbackTarget*>(userdata);
+	target->core->recordReport(target->handle, *timestamp, report->pose);
+}
+
+template <class L, class S, class M>
+void OSVRTrackingCore<L, S, M>::buttonCallback(void *userdata, const OSVR_TimeValue *timestamp, const OSVR_ButtonReport *report)
+{
+	auto target = static_cast<CallbackTarget*>(userdata);
+	auto core = target->core;
+	core->button_subscribers.dispatch(target->handle, target->handle, *report, *timestamp);
+	if (core->button_wait_queue.isWaiting())
+		core->button_wait_queue.wake(target->handle, ButtonEvent{ report->sensor, report->state, *timestamp });
+}
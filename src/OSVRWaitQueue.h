@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// one-shot waiters parked until the next event of a key, e.g. the next report of an interface
+//
+// a waiter is an intrusive node owned by whoever waits, typically a suspended coroutine
+// frame, so waiting never allocates. any thread pushes onto an incoming stack; the
+// dispatching thread moves the stack into per-key lists with collect() and hands every
+// waiter of a key the event with wake(). a woken waiter is forgotten, waiting again means
+// pushing again. a waiter that goes away before it was woken must be cancelled first.
+// waiters still parked when the queue goes away are never woken.
+template <class Event>
+struct OSVRWaiter
+{
+	OSVRWaiter* next = nullptr;
+	uint32_t key = 0;
+	Event event{};
+	void(*resume)(OSVRWaiter*) = nullptr; // called on the dispatching thread after event was set
+	void* context = nullptr; // for resume
+	uint8_t state = 0; // owned by the queue
+};
+
+template <class Event>
+class OSVRWaitQueue
+{
+public:
+	using Waiter = OSVRWaiter<Event>;
+
+	// keys at or above maxKeys are rejected, e.g. the capacity of the pose table
+	explicit OSVRWaitQueue(uint32_t maxKeys) :max_keys(maxKeys) {}
+
+	// any thread. false for a key out of range, the waiter is never woken then
+	bool push(Waiter* waiter)
+	{
+		if (waiter->key >= max_keys)
+			return false;
+		std::lock_guard<std::mutex> guard(mutex);
+		waiter->next = incoming;
+		waiter->state = INCOMING;
+		incoming = waiter;
+		return true;
+	}
+
+	// any thread. once it returns the queue never touches waiter again: a parked waiter is
+	// unlinked, one being resumed on another thread is waited for. true when it was parked
+	bool cancel(Waiter* waiter)
+	{
+		std::unique_lock<std::mutex> guard(mutex);
+		if (waiter->state == INCOMING)
+		{
+			unlink(incoming, waiter);
+		}
+		else if (waiter->state == LISTED)
+		{
+			unlink(lists[waiter->key], waiter);
+			num_waiting--;
+		}
+		else
+		{
+			// from inside its own resume it's done with as soon as resume returns
+			if (resuming == waiter && resuming_thread != std::this_thread::get_id())
+				resumed.wait(guard, [&] { return resuming != waiter; });
+			return false;
+		}
+		waiter->state = IDLE;
+		return true;
+	}
+
+	// dispatching thread. true when anyone waits
+	bool collect()
+	{
+		std::lock_guard<std::mutex> guard(mutex);
+		Waiter* w = incoming;
+		incoming = nullptr;
+		while (w)
+		{
+			Waiter* next = w->next;
+			if (w->key >= lists.size())
+				lists.resize(w->key + 1, nullptr);
+			w->next = lists[w->key];
+			w->state = LISTED;
+			lists[w->key] = w;
+			num_waiting++;
+			w = next;
+		}
+		return num_waiting > 0;
+	}
+
+	// dispatching thread
+	void wake(uint32_t key, const Event& event)
+	{
+		// one waiter at a time, so a resumed waiter can cancel others. a waiter waiting on
+		// the same key again lands on the incoming stack, not on this list
+		std::unique_lock<std::mutex> guard(mutex);
+		while (key < lists.size() && lists[key] != nullptr)
+		{
+			Waiter* w = lists[key];
+			lists[key] = w->next;
+			w->state = IDLE;
+			w->event = event;
+			num_waiting--;
+
+			Waiter* outer = resuming;
+			resuming = w;
+			resuming_thread = std::this_thread::get_id();
+			guard.unlock();
+			w->resume(w);
+			guard.lock();
+			resuming = outer;
+			resumed.notify_all();
+		}
+	}
+
+	bool isWaiting() const { return num_waiting > 0; }
+
+private:
+	enum { IDLE, INCOMING, LISTED };
+
+	static void unlink(Waiter*& head, Waiter* waiter)
+	{
+		for (Waiter** p = &head; *p; p = &(*p)->next)
+		{
+			if (*p == waiter)
+			{
+				*p = waiter->next;
+				return;
+			}
+		}
+	}
+
+	const uint32_t max_keys;
+	std::mutex mutex;
+	std::condition_variable resumed;
+	Waiter* incoming = nullptr;
+	std::vector<Waiter*> lists; // by key
+	Waiter* resuming = nullptr; // being resumed by wake, outside the mutex
+	std::thread::id resuming_thread;
+	std::atomic<size_t> num_waiting{ 0 };
+};
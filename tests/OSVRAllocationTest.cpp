@@ -0,0 +1,255 @@
+// counts heap allocations of a simulated 10 minute session: the poll thread ticking at 1 kHz
+// on 16 interfaces with a filter, a subscriber, a waiter, shared memory and UDP, and a 90 Hz
+// render loop reading frames, poses, predictions, viewers and the camera block. every
+// allocation after one second of warm-up fails the test. set OSVR_ALLOC_TRAP=1 to abort on
+// the first one and look at the stack in a debugger. recording is left out, it writes a file
+//
+//   g++ -std=c++14 -O2 -I../src -I<OSVR include> OSVRAllocationTest.cpp OSVRFakeClientKit.cpp ../src/OSVRCalibration.cpp ../src/OSVRCameraBlock.cpp ../src/OSVRClock.cpp ../src/OSVREyes.cpp ../src/OSVRLog.cpp ../src/OSVRNetwork.cpp ../src/OSVRPoseBatch.cpp ../src/OSVRPoseCodec.cpp ../src/OSVRPoseFilter.cpp ../src/OSVRPoseTable.cpp ../src/OSVRPrediction.cpp ../src/OSVRSession.cpp ../src/OSVRSharedMemory.cpp ../src/OSVRThread.cpp -losvrUtil -lpthread -o OSVRAllocationTest
+
+#include <new>
+#include <map>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "OSVRTrackingCore.h"
+#include "OSVRFakeClientKit.h"
+#include "OSVRTest.h"
+
+namespace
+{
+	std::atomic<bool> counting{ false };
+	std::atomic<uint64_t> allocations{ 0 };
+	std::atomic<uint64_t> allocated_bytes{ 0 };
+	bool trap = false;
+
+	void* allocate(size_t size)
+	{
+		if (counting.load(std::memory_order_relaxed))
+		{
+			allocations++;
+			allocated_bytes += size;
+			if (trap)
+				std::abort();
+		}
+		return std::malloc(size ? size : 1);
+	}
+}
+
+void* operator new(size_t size)
+{
+	void* p = allocate(size);
+	if (p == nullptr)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	void* p = allocate(size);
+	if (p == nullptr)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+namespace
+{
+	using Core = OSVRTrackingCore<NullLockPolicy, FixedStoragePolicy<16>, PodMathPolicy>;
+
+	const uint32_t INTERFACES = 16; // the head and 15 trackers
+	const uint64_t TICKS_PER_SECOND = 1000;
+	const uint64_t WARMUP_TICKS = TICKS_PER_SECOND;
+	const uint64_t SESSION_TICKS = 10 * 60 * TICKS_PER_SECOND;
+	const uint64_t TICKS_PER_FRAME = 11; // about 90 Hz
+
+	uint64_t current_tick = 0;
+
+	OSVR_TimeValue tickTime(uint64_t tick)
+	{
+		return OSVR_TimeValue{ OSVR_TimeValue_Seconds(1 + tick / TICKS_PER_SECOND), OSVR_TimeValue_Microseconds(tick % TICKS_PER_SECOND * 1000) };
+	}
+
+	// every interface moves, the last one loses tracking for a second out of every ten
+	bool sessionPose(uint32_t index, const OSVR_TimeValue& now, OSVR_PoseState& pose)
+	{
+		if (index == INTERFACES - 1 && current_tick / TICKS_PER_SECOND % 10 == 9)
+			return false;
+		double t = double(now.seconds) + now.microseconds * 1e-6 + index;
+		pose.translation.data[0] = 0.3 * std::sin(t);
+		pose.translation.data[1] = 1.6;
+		pose.translation.data[2] = 0.3 * std::cos(t);
+		pose.rotation.data[0] = std::cos(t * 0.5);
+		pose.rotation.data[1] = 0;
+		pose.rotation.data[2] = std::sin(t * 0.5);
+		pose.rotation.data[3] = 0;
+		return true;
+	}
+
+	// the dropouts of the last tracker are counted instead of printed, anything else still goes to stderr
+	std::atomic<uint64_t> lost_reports{ 0 };
+
+	void logHandler(OSVRLogLevel level, const char* module, const char* message)
+	{
+		static const char lost[] = "no pose state: /me/tracker/15";
+		if (level == OSVR_LOG_WARNING && std::strcmp(message, lost) == 0)
+		{
+			lost_reports++;
+			return;
+		}
+		static const char* names[] = { "verbose", "notice", "warning", "error" };
+		std::fprintf(stderr, "[%s] %s: %s\n", names[level], module, message);
+	}
+
+	// what a render loop does once per frame
+	struct RenderLoop
+	{
+		Core& core;
+		std::vector<Core::InterfaceHandle> handles;
+		Core::RenderTarget target;
+		std::map<uint32_t, Core::Viewer> viewers, predicted, merged;
+		std::vector<char> camera_block;
+		OSVRWaiter<Core::PoseEvent> waiter;
+		bool waiting = false;
+		uint64_t wakes = 0;
+		double checksum = 0;
+
+		RenderLoop(Core& core, const std::vector<Core::InterfaceHandle>& handles) :core(core), handles(handles)
+		{
+			target = core.addRenderTarget(1920, 1080);
+			waiter.key = handles[0];
+			waiter.context = this;
+			waiter.resume = [](OSVRWaiter<Core::PoseEvent>* w)
+			{
+				RenderLoop* loop = static_cast<RenderLoop*>(w->context);
+				loop->waiting = false;
+				loop->wakes++;
+			};
+		}
+
+		~RenderLoop()
+		{
+			if (waiting)
+				core.cancelPose(&waiter);
+		}
+
+		void frame()
+		{
+			Core::FrameRef frame = core.captureFrame();
+			if (frame)
+			{
+				for (auto& pose : frame->poses)
+					checksum += pose.translation.x;
+			}
+
+			OSVRVec3 position;
+			OSVRQuat rotation;
+			Core::Clock::time_point timestamp;
+			for (Core::InterfaceHandle handle : handles)
+			{
+				if (core.getInterfacePose(handle, position, rotation, timestamp))
+					checksum += position.y;
+			}
+			Core::Clock::time_point display_time = Core::Clock::now() + std::chrono::milliseconds(20);
+			if (core.getPredictedPose(handles[0], display_time, position, rotation))
+				checksum += position.z;
+
+			core.getViewers(viewers);
+			core.getPredictedViewers(display_time, predicted);
+			core.getViewers(merged, 16, 16);
+			size_t size = Core::writeCameraBlock(predicted, target, camera_block.data(), camera_block.size());
+			if (size > camera_block.size())
+				camera_block.resize(size); // once, on the first frame with a display
+			else
+				checksum += camera_block[0];
+
+			if (waiting == false)
+				waiting = core.waitPose(&waiter);
+		}
+	};
+}
+
+int main()
+{
+	const char* trap_env = std::getenv("OSVR_ALLOC_TRAP");
+	trap = trap_env != nullptr && trap_env[0] == '1';
+
+	OSVRLog::setHandler(logHandler);
+	OSVRFakeClientKit::setPoseSource(sessionPose);
+	OSVRFakeClientKit::setTime(tickTime(0));
+
+	Core core("com.osvr.allocationtest");
+	std::vector<Core::InterfaceHandle> handles;
+	handles.push_back(core.addInterface(Core::HEAD_PATH));
+	for (uint32_t i = 1; i < INTERFACES; i++)
+	{
+		char path[32];
+		std::snprintf(path, sizeof(path), "/me/tracker/%u", i);
+		handles.push_back(core.addInterface(path));
+	}
+	OSVR_CHECK(core.start(false, std::chrono::seconds(1)));
+
+	OSVRFilterParams filter;
+	filter.enabled = true;
+	core.setFilter(handles[1], filter);
+
+	uint64_t reports = 0;
+	uint64_t* reports_ptr = &reports;
+	Core::SubscriptionId subscription = core.subscribePose(Core::ANY_INTERFACE, [reports_ptr](Core::InterfaceHandle, const OSVR_PoseState&, const OSVR_TimeValue&)
+	{
+		(*reports_ptr)++;
+	});
+	OSVR_CHECK(subscription != 0);
+
+	if (core.enableSharedMemory("osvr_allocation_test") == false)
+		std::printf("shared memory not available, left out\n");
+	if (core.enableUdpPublisher("127.0.0.1", 47613) == false)
+		std::printf("UDP publisher not available, left out\n");
+
+	RenderLoop render(core, handles);
+
+	std::chrono::steady_clock::time_point begin;
+	for (current_tick = 1; current_tick <= SESSION_TICKS; current_tick++)
+	{
+		if (current_tick == WARMUP_TICKS)
+		{
+			counting = true;
+			begin = std::chrono::steady_clock::now();
+		}
+		OSVRFakeClientKit::setTime(tickTime(current_tick));
+		core.update();
+		if (current_tick % TICKS_PER_FRAME == 0)
+			render.frame();
+	}
+	counting = false;
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+	std::printf("%llu ticks, %llu frames after warm-up in %.2f s: %llu allocations, %llu bytes\n",
+		(unsigned long long)(SESSION_TICKS - WARMUP_TICKS), (unsigned long long)((SESSION_TICKS - WARMUP_TICKS) / TICKS_PER_FRAME), seconds,
+		(unsigned long long)allocations.load(), (unsigned long long)allocated_bytes.load());
+	OSVR_CHECK(allocations == 0);
+
+	// the session did happen
+	OSVR_CHECK(reports > (SESSION_TICKS - WARMUP_TICKS) * (INTERFACES - 1));
+	OSVR_CHECK(render.wakes > 0);
+	OSVR_CHECK(render.predicted.empty() == false);
+	// the last tracker dropped out once every ten seconds, and was reported lost each time
+	std::printf("%llu tracking losses reported\n", (unsigned long long)lost_reports.load());
+	OSVR_CHECK(lost_reports == SESSION_TICKS / (10 * TICKS_PER_SECOND));
+	std::printf("(checksum %g)\n", render.checksum);
+
+	core.unsubscribe(subscription);
+	return OSVRTest::result();
+}
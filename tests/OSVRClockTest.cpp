@@ -0,0 +1,94 @@
+// OSVRClockMapper on synthetic reports at 1 kHz: a known offset and drift, transport delay
+// with exponential jitter and late spikes. checks the drift and the mapped times against
+// the truth on every tick, and what it returns before the first report
+//
+//   g++ -std=c++14 -O2 -I../src -I<OSVR include> OSVRClockTest.cpp ../src/OSVRClock.cpp -o OSVRClockTest
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include "OSVRClock.h"
+#include "OSVRTest.h"
+
+namespace
+{
+	using Clock = OSVRClockMapper::Clock;
+
+	const int TICKS_PER_SECOND = 1000;
+	const double MIN_DELAY = 0.0005; // seconds, the transport delay without jitter
+	const double MEAN_JITTER = 0.001;
+
+	Clock::time_point toLocal(double seconds)
+	{
+		return Clock::time_point(std::chrono::hours(1)) + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+	}
+
+	OSVR_TimeValue toRemote(int64_t tick)
+	{
+		return OSVR_TimeValue{ OSVR_TimeValue_Seconds(1000000 + tick / TICKS_PER_SECOND), OSVR_TimeValue_Microseconds(tick % TICKS_PER_SECOND * 1000) };
+	}
+
+	double seconds(Clock::duration d)
+	{
+		return std::chrono::duration<double>(d).count();
+	}
+
+	void testSession(double offset, double drift, uint64_t seed)
+	{
+		OSVRTest::Random random(seed);
+		OSVRClockMapper mapper;
+		double worst_error = 0.0;
+		double early_drift = 0.0;
+
+		for (int64_t tick = 0; tick < 120 * TICKS_PER_SECOND; tick++)
+		{
+			double r = double(tick) / TICKS_PER_SECOND;
+			// arrival without delay, in local seconds
+			double ideal = offset + r * (1.0 + drift);
+			double delay = MIN_DELAY - MEAN_JITTER * std::log(1.0 - random.uniform(0, 1));
+			if (random.next() % 100 == 0)
+				delay += 0.02;
+			mapper.addSample(toRemote(tick), toLocal(ideal + delay));
+
+			if (tick == 5 * TICKS_PER_SECOND)
+				early_drift = mapper.getDrift();
+			// the whole window is filled once, from then on every tick maps within a fraction of the jitter
+			if (tick >= 60 * TICKS_PER_SECOND)
+			{
+				double error = seconds(mapper.toSteady(toRemote(tick)) - toLocal(ideal + MIN_DELAY));
+				worst_error = std::fmax(worst_error, std::fabs(error));
+			}
+		}
+
+		double drift_error = std::fabs(mapper.getDrift() - drift);
+		std::printf("offset %.3f s, drift %+.0f ppm: drift error %.2f ppm, worst mapping error %.1f us\n",
+			offset, drift * 1e6, drift_error * 1e6, worst_error * 1e6);
+		OSVR_CHECK(mapper.isValid());
+		// too short a window to fit, no noise handed out as drift
+		OSVR_CHECK(early_drift == 0.0);
+		OSVR_CHECK(drift_error < 2e-6);
+		OSVR_CHECK(worst_error < 100e-6);
+	}
+}
+
+int main()
+{
+	OSVRClockMapper empty;
+	OSVR_CHECK(empty.isValid() == false);
+	OSVR_CHECK(empty.toSteady(toRemote(0)) == Clock::time_point());
+
+	testSession(0.25, 0.0, 1);
+	testSession(-3.0, 100e-6, 2);
+	testSession(12.5, -40e-6, 3);
+	testSession(0.0, 500e-6, 4);
+
+	// a reset forgets the epoch
+	OSVRClockMapper mapper;
+	mapper.addSample(toRemote(0), toLocal(1.0));
+	OSVR_CHECK(mapper.toSteady(toRemote(0)) == toLocal(1.0));
+	mapper.reset();
+	OSVR_CHECK(mapper.toSteady(toRemote(0)) == Clock::time_point());
+
+	return OSVRTest::result();
+}
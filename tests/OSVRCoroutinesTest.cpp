@@ -0,0 +1,465 @@
+// the C++20 layer on OSVRWaitQueue: waiters cancelled while a dispatching thread wakes them,
+// coroutine frames destroyed while their report is being dispatched, resumption through an
+// executor on another thread, and readSession over a recorded file
+//
+//   g++ -std=c++20 -O2 -I../src OSVRCoroutinesTest.cpp ../src/OSVRSession.cpp ../src/OSVRPoseCodec.cpp ../src/OSVRLog.cpp -lpthread -o OSVRCoroutinesTest
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <utility>
+#include <cmath>
+#include <cstdio>
+
+#include "OSVRCoroutines.h"
+#include "OSVRTest.h"
+
+#ifndef OSVR_HAS_COROUTINES
+#error "build with -std=c++20"
+#endif
+
+namespace
+{
+	struct Event
+	{
+		uint32_t key;
+		uint64_t tick;
+	};
+
+	using Queue = OSVRWaitQueue<Event>;
+	using Waiter = OSVRWaiter<Event>;
+
+	const uint32_t KEYS = 8;
+
+	// the poll thread: every tick collects new waiters and wakes every key once
+	class PollThread
+	{
+	public:
+		explicit PollThread(Queue& queue) :queue(queue), thread([this] { run(); }) {}
+		~PollThread() { stop(); }
+
+		void stop()
+		{
+			running = false;
+			if (thread.joinable())
+				thread.join();
+		}
+
+		uint64_t getTicks() const { return ticks.load(); }
+
+	private:
+		void run()
+		{
+			for (uint64_t tick = 1; running.load(std::memory_order_relaxed); tick++)
+			{
+				if (queue.collect())
+				{
+					for (uint32_t key = 0; key < KEYS; key++)
+						queue.wake(key, Event{ key, tick });
+				}
+				ticks.store(tick);
+				// so the test also progresses on a single core
+				if (tick % 16 == 0)
+					std::this_thread::yield();
+			}
+		}
+
+		Queue& queue;
+		std::atomic<bool> running{ true };
+		std::atomic<uint64_t> ticks{ 0 };
+		std::thread thread;
+	};
+
+	// one wait of the cancel test, never reused
+	struct Wait
+	{
+		Waiter waiter;
+		std::atomic<int> resuming{ 0 };
+		std::atomic<bool> woken{ false };
+		std::atomic<bool> dropped{ false }; // the owner let go of it
+	};
+
+	std::atomic<uint64_t> late_resumes{ 0 };
+	std::atomic<uint64_t> total_resumes{ 0 };
+
+	void resumeWait(Waiter* w)
+	{
+		Wait* wait = static_cast<Wait*>(w->context);
+		wait->resuming.fetch_add(1);
+		if (wait->dropped.load())
+			late_resumes++;
+		// now and then let a cancel() run while the resume is in flight, also on one core
+		if (total_resumes.fetch_add(1, std::memory_order_relaxed) % 16 == 0)
+			std::this_thread::yield();
+		wait->woken.store(true);
+		wait->resuming.fetch_sub(1);
+	}
+
+	// two threads pushing waiters and cancelling them at random points of the dispatch. every
+	// wait is either unlinked by cancel or woken exactly once, and done with when cancel returns
+	void testCancelRace()
+	{
+		const int threads = 2;
+		const int per_thread = 20000;
+
+		Queue queue(KEYS);
+		std::vector<Wait> waits(threads * per_thread);
+		std::atomic<uint64_t> parked{ 0 }, woken{ 0 }, neither{ 0 }, both{ 0 }, still_resuming{ 0 };
+		PollThread poll(queue);
+
+		std::vector<std::thread> owners;
+		for (int t = 0; t < threads; t++)
+		{
+			owners.emplace_back([&, t]
+			{
+				for (int n = 0; n < per_thread; n++)
+				{
+					Wait& wait = waits[t * per_thread + n];
+					wait.waiter.key = uint32_t(n % KEYS);
+					wait.waiter.context = &wait;
+					wait.waiter.resume = resumeWait;
+					OSVR_CHECK(queue.push(&wait.waiter));
+					for (int spin = n % 4; spin > 0; spin--)
+						std::this_thread::yield();
+
+					bool was_parked = queue.cancel(&wait.waiter);
+					if (wait.resuming.load() != 0)
+						still_resuming++;
+					bool was_woken = wait.woken.load();
+					wait.dropped.store(true);
+					(was_parked ? parked : woken)++;
+					if (was_parked && was_woken)
+						both++;
+					if (!was_parked && !was_woken)
+						neither++;
+				}
+			});
+		}
+		for (auto& t : owners)
+			t.join();
+		// a wait that survived its cancel would be woken now
+		uint64_t tick = poll.getTicks();
+		while (poll.getTicks() < tick + 100)
+			std::this_thread::yield();
+		poll.stop();
+
+		std::printf("%d waits: %llu cancelled parked, %llu woken first, %llu late, %llu resuming after cancel\n",
+			threads * per_thread, (unsigned long long)parked.load(), (unsigned long long)woken.load(),
+			(unsigned long long)late_resumes.load(), (unsigned long long)still_resuming.load());
+		OSVR_CHECK(woken > 0);
+		OSVR_CHECK(late_resumes == 0);
+		OSVR_CHECK(still_resuming == 0);
+		OSVR_CHECK(both == 0);
+		OSVR_CHECK(neither == 0);
+		OSVR_CHECK(queue.isWaiting() == false);
+	}
+
+	// a coroutine the test owns and destroys from outside
+	struct Task
+	{
+		struct promise_type
+		{
+			Task get_return_object() { return Task{ std::coroutine_handle<promise_type>::from_promise(*this) }; }
+			std::suspend_never initial_suspend() noexcept { return {}; }
+			std::suspend_always final_suspend() noexcept { return {}; }
+			void return_void() {}
+			void unhandled_exception() { std::terminate(); }
+		};
+
+		std::coroutine_handle<promise_type> handle;
+	};
+
+	// what a listener frame reports to the test, one per frame and never reused
+	struct Listener
+	{
+		uint32_t key = 0;
+		uint64_t resumes = 0;
+		uint64_t last_tick = 0;
+		bool destroyed = false;
+		Task* other = nullptr; // destroyed on the first resume, see testDestroyInsideResume
+	};
+
+	struct Counts
+	{
+		uint64_t resumes = 0;
+		uint64_t late = 0;
+		uint64_t wrong_thread = 0;
+		uint64_t wrong_event = 0;
+		std::thread::id thread;
+	};
+
+	Task listen(Queue& queue, OSVRExecutor executor, Listener* listener, Counts* counts)
+	{
+		for (;;)
+		{
+			Event event = co_await OSVRAwaitable<Event>(&queue, listener->key, executor);
+			counts->resumes++;
+			if (listener->destroyed)
+				counts->late++;
+			if (std::this_thread::get_id() != counts->thread)
+				counts->wrong_thread++;
+			if (event.key != listener->key || event.tick <= listener->last_tick)
+				counts->wrong_event++;
+			listener->resumes++;
+			listener->last_tick = event.tick;
+			if (listener->other)
+			{
+				listener->other->handle.destroy();
+				listener->other = nullptr;
+			}
+		}
+	}
+
+	Task listenOnce(Queue& queue, Listener* listener)
+	{
+		Event event = co_await OSVRAwaitable<Event>(&queue, listener->key, OSVRExecutor());
+		listener->resumes++;
+		listener->last_tick = event.tick;
+	}
+
+	// an executor for the test's own thread: the poll thread posts, the test drains
+	class Inbox
+	{
+	public:
+		void post(std::coroutine_handle<> handle)
+		{
+			std::lock_guard<std::mutex> guard(mutex);
+			handles.push_back(handle);
+		}
+
+		void drain(std::vector<std::coroutine_handle<>>& out)
+		{
+			out.clear();
+			std::lock_guard<std::mutex> guard(mutex);
+			out.swap(handles);
+		}
+
+		// after the frame was destroyed: its awaitable cancelled the wait, which also waited
+		// out a post in flight, so a stale handle can only be queued already
+		size_t drop(std::coroutine_handle<> handle)
+		{
+			std::lock_guard<std::mutex> guard(mutex);
+			size_t before = handles.size();
+			handles.erase(std::remove(handles.begin(), handles.end(), handle), handles.end());
+			return before - handles.size();
+		}
+
+	private:
+		std::mutex mutex;
+		std::vector<std::coroutine_handle<>> handles;
+	};
+
+	// frames created, resumed and destroyed on this thread while the poll thread wakes them
+	// and posts them to the executor, at random points of the dispatch
+	void testExecutorRace()
+	{
+		const int frames = 30000;
+		const size_t max_live = 64;
+
+		Queue queue(KEYS);
+		Inbox inbox;
+		Inbox* inbox_ptr = &inbox;
+		OSVRExecutor executor([inbox_ptr](std::coroutine_handle<> handle) { inbox_ptr->post(handle); });
+		std::vector<Listener> listeners(frames);
+		std::vector<std::pair<Task, Listener*>> live;
+		std::vector<std::coroutine_handle<>> ready;
+		Counts counts;
+		counts.thread = std::this_thread::get_id();
+		uint64_t stale = 0;
+		OSVRTest::Random random(7);
+		PollThread poll(queue);
+
+		int created = 0;
+		while (created < frames || live.empty() == false)
+		{
+			uint32_t action = random.next() % 4;
+			if (action == 0 && created < frames && live.size() < max_live)
+			{
+				Listener* listener = &listeners[created++];
+				listener->key = random.next() % KEYS;
+				live.emplace_back(listen(queue, executor, listener, &counts), listener);
+			}
+			else if (action == 1 && live.empty() == false && (created == frames || live.size() > max_live / 2))
+			{
+				size_t i = random.next() % live.size();
+				std::coroutine_handle<> handle = live[i].first.handle;
+				handle.destroy();
+				live[i].second->destroyed = true;
+				stale += inbox.drop(handle);
+				live[i] = live.back();
+				live.pop_back();
+			}
+			else
+			{
+				inbox.drain(ready);
+				for (std::coroutine_handle<> handle : ready)
+					handle.resume();
+				if (action == 3)
+					std::this_thread::yield();
+			}
+		}
+		poll.stop();
+		inbox.drain(ready);
+
+		std::printf("%d frames: %llu resumes through the executor, %llu stale handles dropped, %llu late, %llu on another thread\n",
+			frames, (unsigned long long)counts.resumes, (unsigned long long)stale, (unsigned long long)counts.late,
+			(unsigned long long)counts.wrong_thread);
+		OSVR_CHECK(counts.resumes > 0);
+		OSVR_CHECK(counts.late == 0);
+		OSVR_CHECK(counts.wrong_thread == 0);
+		OSVR_CHECK(counts.wrong_event == 0);
+		OSVR_CHECK(ready.empty());
+		OSVR_CHECK(queue.isWaiting() == false);
+	}
+
+	// frames resumed inline on the dispatching thread, one destroying the other on the same
+	// key while the wake is half way through the list, and a frame on a key the queue rejects
+	void testDestroyInsideResume()
+	{
+		Queue queue(KEYS);
+		Counts counts;
+		counts.thread = std::this_thread::get_id();
+		Listener a, b;
+		a.key = b.key = 3;
+		Task ta = listen(queue, OSVRExecutor(), &a, &counts);
+		Task tb = listen(queue, OSVRExecutor(), &b, &counts);
+		a.other = &tb;
+		b.other = &ta;
+
+		OSVR_CHECK(queue.collect());
+		queue.wake(3, Event{ 3, 1 });
+		// whichever ran first destroyed the other before the wake reached it
+		OSVR_CHECK(a.resumes + b.resumes == 1);
+		OSVR_CHECK(counts.resumes == 1);
+		Task& survivor = a.resumes == 1 ? ta : tb;
+
+		// waiting again lands on the incoming stack, not on the list being woken
+		OSVR_CHECK(queue.collect());
+		queue.wake(3, Event{ 3, 2 });
+		OSVR_CHECK(counts.resumes == 2);
+		OSVR_CHECK(counts.wrong_event == 0);
+		survivor.handle.destroy();
+		OSVR_CHECK(queue.collect() == false);
+
+		// a key out of range resumes at once with a default event
+		Listener c;
+		c.key = KEYS;
+		Task tc = listenOnce(queue, &c);
+		OSVR_CHECK(c.resumes == 1 && c.last_tick == 0);
+		OSVR_CHECK(tc.handle.done());
+		tc.handle.destroy();
+	}
+
+	const char* SESSION_FILE = "osvr_coroutines_test.session";
+
+	void testReadSession()
+	{
+		const double precision = 0.001;
+		const uint32_t interfaces = 2;
+		const int64_t samples_per_interface = 3000; // 3 s at 1 kHz, less than the writer queue holds
+		const char* paths[interfaces] = { "/me/head", "/me/hands/left" };
+
+		std::vector<OSVRPoseSample> written;
+		{
+			OSVRSessionWriter writer;
+			OSVR_CHECK(writer.open(SESSION_FILE, precision));
+			for (uint32_t i = 0; i < interfaces; i++)
+				writer.addInterface(i, paths[i]);
+			OSVRTest::Random random(3);
+			for (int64_t n = 0; n < samples_per_interface; n++)
+			{
+				for (uint32_t i = 0; i < interfaces; i++)
+				{
+					OSVRPoseSample s;
+					s.handle = i;
+					s.path = nullptr;
+					for (int k = 0; k < 3; k++)
+						s.translation[k] = random.uniform(-2, 2);
+					random.quaternion(s.rotation);
+					s.timestamp = 1000000000 + n * 1000;
+					s.valid = random.next() % 50 != 0;
+					writer.write(s);
+					written.push_back(s);
+				}
+			}
+			writer.close();
+			OSVR_CHECK(writer.getDropped() == 0);
+		}
+
+		OSVRSessionReader reader;
+		OSVR_CHECK(reader.open(SESSION_FILE));
+		OSVR_CHECK(reader.getBlocks().size() >= 3);
+
+		// the whole session in order
+		size_t count = 0, mismatches = 0;
+		for (const OSVRPoseSample& s : readSession(reader))
+		{
+			if (count >= written.size())
+			{
+				count++;
+				continue;
+			}
+			const OSVRPoseSample& w = written[count++];
+			float position_error = 0, dot = 0;
+			for (int k = 0; k < 3; k++)
+				position_error = std::fmax(position_error, std::fabs(s.translation[k] - w.translation[k]));
+			for (int k = 0; k < 4; k++)
+				dot += s.rotation[k] * w.rotation[k];
+			bool same = s.handle == w.handle && s.timestamp == w.timestamp && s.valid == w.valid &&
+				position_error <= precision && std::fabs(dot) > 0.9999f && s.path != nullptr && std::string(s.path) == paths[w.handle];
+			mismatches += same ? 0 : 1;
+		}
+		std::printf("%zu samples written, %zu read back in %zu blocks, %zu mismatches\n",
+			written.size(), count, reader.getBlocks().size(), mismatches);
+		OSVR_CHECK(count == written.size());
+		OSVR_CHECK(mismatches == 0);
+
+		// from a seek: the block holding the time, to the end
+		const OSVRSessionReader::Block& block = reader.getBlocks()[1];
+		OSVR_CHECK(reader.seek(block.begin + 10000));
+		size_t first = 0;
+		while (first < written.size() && written[first].timestamp < block.begin)
+			first++;
+		count = 0;
+		bool ordered = true;
+		for (const OSVRPoseSample& s : readSession(reader))
+		{
+			ordered = ordered && first + count < written.size() && s.timestamp == written[first + count].timestamp && s.handle == written[first + count].handle;
+			count++;
+		}
+		OSVR_CHECK(ordered);
+		OSVR_CHECK(count == written.size() - first);
+
+		// a loop left early destroys its generator, the next one goes on from the reader's position
+		OSVR_CHECK(reader.seek(0));
+		count = 0;
+		for (const OSVRPoseSample& s : readSession(reader))
+		{
+			(void)s;
+			if (++count == 10)
+				break;
+		}
+		int64_t next_timestamp = -1;
+		for (const OSVRPoseSample& s : readSession(reader))
+		{
+			next_timestamp = s.timestamp;
+			break;
+		}
+		OSVR_CHECK(next_timestamp == written[10].timestamp);
+
+		reader.close();
+		std::remove(SESSION_FILE);
+	}
+}
+
+int main()
+{
+	testCancelRace();
+	testExecutorRace();
+	testDestroyInsideResume();
+	testReadSession();
+	return OSVRTest::result();
+}
@@ -0,0 +1,394 @@
+#include "OSVRFakeClientKit.h"
+
+#include <deque>
+#include <string>
+#include <cstring>
+
+// ignore conflict define
+#pragma push_macro("ignore")
+#undef near
+#undef far
+#include "osvr/ClientKit/ContextC.h"
+#include "osvr/ClientKit/InterfaceC.h"
+#include "osvr/ClientKit/InterfaceStateC.h"
+#include "osvr/ClientKit/InterfaceCallbackC.h"
+#include "osvr/ClientKit/DisplayC.h"
+#include "osvr/ClientKit/ServerAutoStartC.h"
+#pragma pop_macro("ignore")
+
+struct OSVR_ClientContextObject
+{
+	int open = 0;
+};
+
+struct OSVR_ClientInterfaceObject
+{
+	uint32_t index = 0;
+	std::string path;
+	bool has_state = false;
+	OSVR_PoseState pose;
+	OSVR_TimeValue timestamp;
+	OSVR_PoseCallback pose_callback = nullptr;
+	void* pose_userdata = nullptr;
+};
+
+struct OSVR_DisplayConfigObject
+{
+	OSVR_ClientContext ctx = nullptr;
+};
+
+namespace
+{
+	const char* HEAD_PATH = "/me/head";
+	const double HALF_IPD = 0.032;
+	const OSVR_DisplayDimension WIDTH = 1920;
+	const OSVR_DisplayDimension HEIGHT = 1080;
+
+	OSVR_ClientContextObject context;
+	OSVR_DisplayConfigObject display;
+	// never moves, the tracker keeps the handles
+	std::deque<OSVR_ClientInterfaceObject> interfaces;
+	OSVRFakeClientKit::PoseSource source = nullptr;
+	OSVR_TimeValue now = { 1, 0 };
+
+	OSVR_Pose3 identity()
+	{
+		OSVR_Pose3 pose;
+		std::memset(&pose, 0, sizeof(pose));
+		pose.rotation.data[0] = 1;
+		return pose;
+	}
+
+	OSVR_ClientInterfaceObject* findInterface(const char* path)
+	{
+		for (auto& i : interfaces)
+		{
+			if (i.path == path)
+				return &i;
+		}
+		return nullptr;
+	}
+
+	bool validEye(OSVR_DisplayConfig disp, OSVR_ViewerCount viewer, OSVR_EyeCount eye)
+	{
+		return disp == &display && viewer == 0 && eye < 2;
+	}
+
+	bool validSurface(OSVR_DisplayConfig disp, OSVR_ViewerCount viewer, OSVR_EyeCount eye, OSVR_SurfaceCount surface)
+	{
+		return validEye(disp, viewer, eye) && surface == 0;
+	}
+
+	// v rotated by the unit quaternion q, w x y z
+	void rotate(const OSVR_Quaternion& q, const double v[3], double out[3])
+	{
+		double w = q.data[0], x = q.data[1], y = q.data[2], z = q.data[3];
+		double tx = 2 * (y * v[2] - z * v[1]), ty = 2 * (z * v[0] - x * v[2]), tz = 2 * (x * v[1] - y * v[0]);
+		out[0] = v[0] + w * tx + (y * tz - z * ty);
+		out[1] = v[1] + w * ty + (z * tx - x * tz);
+		out[2] = v[2] + w * tz + (x * ty - y * tx);
+	}
+
+	// symmetric frustum of 90 degrees vertically, OpenGL style in the requested layout
+	void projection(double z_near, double z_far, OSVR_MatrixConventions flags, double m[16])
+	{
+		double aspect = double(WIDTH / 2) / HEIGHT;
+		double f = 1.0; // cot(45 degrees)
+		double c[16] = {}; // column-major, column vectors
+		c[0] = f / aspect;
+		c[5] = f;
+		c[10] = (z_far + z_near) / (z_near - z_far);
+		c[11] = -1;
+		c[14] = 2 * z_far * z_near / (z_near - z_far);
+		// row-major with row vectors is the same memory, one flag alone transposes
+		bool transpose = ((flags & OSVR_MATRIX_ROWMAJOR) != 0) != ((flags & OSVR_MATRIX_ROWVECTORS) != 0);
+		for (int r = 0; r < 4; r++)
+			for (int col = 0; col < 4; col++)
+				m[r * 4 + col] = transpose ? c[col * 4 + r] : c[r * 4 + col];
+	}
+}
+
+namespace OSVRFakeClientKit
+{
+	void setPoseSource(PoseSource s)
+	{
+		source = s;
+	}
+
+	void setTime(const OSVR_TimeValue& t)
+	{
+		now = t;
+	}
+
+	uint32_t getInterfaceCount()
+	{
+		return uint32_t(interfaces.size());
+	}
+
+	OSVR_ClientInterface getInterface(uint32_t index)
+	{
+		return index < interfaces.size() ? &interfaces[index] : nullptr;
+	}
+
+	void report()
+	{
+		for (auto& i : interfaces)
+		{
+			if (source)
+				i.has_state = source(i.index, now, i.pose);
+			else
+			{
+				i.pose = identity();
+				i.has_state = true;
+			}
+			if (i.has_state == false)
+				continue;
+			i.timestamp = now;
+			if (i.pose_callback)
+			{
+				OSVR_PoseReport r;
+				r.sensor = 0;
+				r.pose = i.pose;
+				i.pose_callback(i.pose_userdata, &i.timestamp, &r);
+			}
+		}
+	}
+
+	void reset()
+	{
+		interfaces.clear();
+		source = nullptr;
+		now = OSVR_TimeValue{ 1, 0 };
+	}
+}
+
+// context
+
+OSVR_ClientContext osvrClientInit(const char applicationIdentifier[], uint32_t flags)
+{
+	context.open++;
+	return &context;
+}
+
+OSVR_ClientContext osvrClientInitHost(const char applicationIdentifier[], const char host[], uint32_t flags)
+{
+	return osvrClientInit(applicationIdentifier, flags);
+}
+
+OSVR_ReturnCode osvrClientUpdate(OSVR_ClientContext ctx)
+{
+	if (ctx != &context)
+		return OSVR_RETURN_FAILURE;
+	OSVRFakeClientKit::report();
+	return OSVR_RETURN_SUCCESS;
+}
+
+OSVR_ReturnCode osvrClientCheckStatus(OSVR_ClientContext ctx)
+{
+	return ctx == &context && context.open > 0 ? OSVR_RETURN_SUCCESS : OSVR_RETURN_FAILURE;
+}
+
+OSVR_ReturnCode osvrClientShutdown(OSVR_ClientContext ctx)
+{
+	if (ctx != &context)
+		return OSVR_RETURN_FAILURE;
+	context.open--;
+	return OSVR_RETURN_SUCCESS;
+}
+
+void osvrClientAttemptServerAutoStart()
+{
+}
+
+void osvrClientReleaseAutoStartedServer()
+{
+}
+
+// interfaces
+
+OSVR_ReturnCode osvrClientGetInterface(OSVR_ClientContext ctx, const char path[], OSVR_ClientInterface* iface)
+{
+	if (ctx != &context)
+		return OSVR_RETURN_FAILURE;
+	// the same path gives the same interface, the tracker may ask more than once
+	OSVR_ClientInterfaceObject* found = findInterface(path);
+	if (found == nullptr)
+	{
+		interfaces.emplace_back();
+		found = &interfaces.back();
+		found->index = uint32_t(interfaces.size() - 1);
+		found->path = path;
+	}
+	*iface = found;
+	return OSVR_RETURN_SUCCESS;
+}
+
+OSVR_ReturnCode osvrClientFreeInterface(OSVR_ClientContext ctx, OSVR_ClientInterface iface)
+{
+	// kept, later handles stay valid and the index stays stable
+	return ctx == &context && iface ? OSVR_RETURN_SUCCESS : OSVR_RETURN_FAILURE;
+}
+
+OSVR_ReturnCode osvrRegisterPoseCallback(OSVR_ClientInterface iface, OSVR_PoseCallback cb, void* userdata)
+{
+	iface->pose_callback = cb;
+	iface->pose_userdata = userdata;
+	return OSVR_RETURN_SUCCESS;
+}
+
+// no buttons, velocities or accelerations are ever reported
+
+OSVR_ReturnCode osvrRegisterButtonCallback(OSVR_ClientInterface iface, OSVR_ButtonCallback cb, void* userdata)
+{
+	return OSVR_RETURN_SUCCESS;
+}
+
+OSVR_ReturnCode osvrRegisterVelocityCallback(OSVR_ClientInterface iface, OSVR_VelocityCallback cb, void* userdata)
+{
+	return OSVR_RETURN_SUCCESS;
+}
+
+OSVR_ReturnCode osvrRegisterAccelerationCallback(OSVR_ClientInterface iface, OSVR_AccelerationCallback cb, void* userdata)
+{
+	return OSVR_RETURN_SUCCESS;
+}
+
+OSVR_ReturnCode osvrGetPoseState(OSVR_ClientInterface iface, OSVR_TimeValue* timestamp, OSVR_PoseState* state)
+{
+	if (iface == nullptr || iface->has_state == false)
+		return OSVR_RETURN_FAILURE;
+	*timestamp = iface->timestamp;
+	*state = iface->pose;
+	return OSVR_RETURN_SUCCESS;
+}
+
+OSVR_ReturnCode osvrGetVelocityState(OSVR_ClientInterface iface, OSVR_TimeValue* timestamp, OSVR_VelocityState* state)
+{
+	return OSVR_RETURN_FAILURE;
+}
+
+OSVR_ReturnCode osvrGetAccelerationState(OSVR_ClientInterface iface, OSVR_TimeValue* timestamp, OSVR_AccelerationState* state)
+{
+	return OSVR_RETURN_FAILURE;
+}
+
+// display
+
+OSVR_ReturnCode osvrClientGetDisplay(OSVR_ClientContext ctx, OSVR_DisplayConfig* disp)
+{
+	if (ctx != &context)
+		return OSVR_RETURN_FAILURE;
+	display.ctx = ctx;
+	*disp = &display;
+	return OSVR_RETURN_SUCCESS;
+}
+
+OSVR_ReturnCode osvrClientFreeDisplay(OSVR_DisplayConfig disp)
+{
+	return disp == &display ? OSVR_RETURN_SUCCESS : OSVR_RETURN_FAILURE;
+}
+
+OSVR_ReturnCode osvrClientCheckDisplayStartup(OSVR_DisplayConfig disp)
+{
+	return disp == &display ? OSVR_RETURN_SUCCESS : OSVR_RETURN_FAILURE;
+}
+
+OSVR_ReturnCode osvrClientGetNumDisplayInputs(OSVR_DisplayConfig disp, OSVR_DisplayInputCount* numDisplayInputs)
+{
+	*numDisplayInputs = 1;
+	return OSVR_RETURN_SUCCESS;
+}
+
+OSVR_ReturnCode osvrClientGetDisplayDimensions(OSVR_DisplayConfig disp, OSVR_DisplayInputCount displayInputIndex, OSVR_DisplayDimension* width, OSVR_DisplayDimension* height)
+{
+	if (disp != &display || displayInputIndex != 0)
+		return OSVR_RETURN_FAILURE;
+	*width = WIDTH;
+	*height = HEIGHT;
+	return OSVR_RETURN_SUCCESS;
+}
+
+OSVR_ReturnCode osvrClientGetNumViewers(OSVR_DisplayConfig disp, OSVR_ViewerCount* viewers)
+{
+	*viewers = 1;
+	return OSVR_RETURN_SUCCESS;
+}
+
+OSVR_ReturnCode osvrClientGetViewerPose(OSVR_DisplayConfig disp, OSVR_ViewerCount viewer, OSVR_Pose3* pose)
+{
+	OSVR_ClientInterfaceObject* head = findInterface(HEAD_PATH);
+	if (disp != &display || viewer != 0 || head == nullptr || head->has_state == false)
+		return OSVR_RETURN_FAILURE;
+	*pose = head->pose;
+	return OSVR_RETURN_SUCCESS;
+}
+
+OSVR_ReturnCode osvrClientGetNumEyesForViewer(OSVR_DisplayConfig disp, OSVR_ViewerCount viewer, OSVR_EyeCount* eyes)
+{
+	if (disp != &display || viewer != 0)
+		return OSVR_RETURN_FAILURE;
+	*eyes = 2;
+	return OSVR_RETURN_SUCCESS;
+}
+
+OSVR_ReturnCode osvrClientGetViewerEyePose(OSVR_DisplayConfig disp, OSVR_ViewerCount viewer, OSVR_EyeCount eye, OSVR_Pose3* pose)
+{
+	OSVR_Pose3 head;
+	if (validEye(disp, viewer, eye) == false || osvrClientGetViewerPose(disp, viewer, &head) != OSVR_RETURN_SUCCESS)
+		return OSVR_RETURN_FAILURE;
+	double offset[3] = { eye == 0 ? -HALF_IPD : HALF_IPD, 0, 0 };
+	double rotated[3];
+	rotate(head.rotation, offset, rotated);
+	*pose = head;
+	for (int k = 0; k < 3; k++)
+		pose->translation.data[k] += rotated[k];
+	return OSVR_RETURN_SUCCESS;
+}
+
+OSVR_ReturnCode osvrClientGetNumSurfacesForViewerEye(OSVR_DisplayConfig disp, OSVR_ViewerCount viewer, OSVR_EyeCount eye, OSVR_SurfaceCount* surfaces)
+{
+	if (validEye(disp, viewer, eye) == false)
+		return OSVR_RETURN_FAILURE;
+	*surfaces = 1;
+	return OSVR_RETURN_SUCCESS;
+}
+
+OSVR_ReturnCode osvrClientGetRelativeViewportForViewerEyeSurface(OSVR_DisplayConfig disp, OSVR_ViewerCount viewer, OSVR_EyeCount eye, OSVR_SurfaceCount surface,
+	OSVR_ViewportDimension* left, OSVR_ViewportDimension* bottom, OSVR_ViewportDimension* width, OSVR_ViewportDimension* height)
+{
+	if (validSurface(disp, viewer, eye, surface) == false)
+		return OSVR_RETURN_FAILURE;
+	*left = eye * (WIDTH / 2);
+	*bottom = 0;
+	*width = WIDTH / 2;
+	*height = HEIGHT;
+	return OSVR_RETURN_SUCCESS;
+}
+
+OSVR_ReturnCode osvrClientGetViewerEyeSurfaceDisplayInputIndex(OSVR_DisplayConfig disp, OSVR_ViewerCount viewer, OSVR_EyeCount eye, OSVR_SurfaceCount surface, OSVR_DisplayInputCount* displayInput)
+{
+	if (validSurface(disp, viewer, eye, surface) == false)
+		return OSVR_RETURN_FAILURE;
+	*displayInput = 0;
+	return OSVR_RETURN_SUCCESS;
+}
+
+OSVR_ReturnCode osvrClientGetViewerEyeSurfaceProjectionMatrixd(OSVR_DisplayConfig disp, OSVR_ViewerCount viewer, OSVR_EyeCount eye, OSVR_SurfaceCount surface,
+	double z_near, double z_far, OSVR_MatrixConventions flags, double* matrix)
+{
+	if (validSurface(disp, viewer, eye, surface) == false)
+		return OSVR_RETURN_FAILURE;
+	projection(z_near, z_far, flags, matrix);
+	return OSVR_RETURN_SUCCESS;
+}
+
+OSVR_ReturnCode osvrClientGetViewerEyeSurfaceProjectionMatrixf(OSVR_DisplayConfig disp, OSVR_ViewerCount viewer, OSVR_EyeCount eye, OSVR_SurfaceCount surface,
+	double z_near, double z_far, OSVR_MatrixConventions flags, float* matrix)
+{
+	double m[16];
+	if (osvrClientGetViewerEyeSurfaceProjectionMatrixd(disp, viewer, eye, surface, z_near, z_far, flags, m) != OSVR_RETURN_SUCCESS)
+		return OSVR_RETURN_FAILURE;
+	for (int i = 0; i < 16; i++)
+		matrix[i] = float(m[i]);
+	return OSVR_RETURN_SUCCESS;
+}
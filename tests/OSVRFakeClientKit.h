@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+#include "osvr/Util/ClientOpaqueTypesC.h"
+#include "osvr/Util/TimeValueC.h"
+#include "osvr/Util/Pose3C.h"
+
+// an in-process stand-in for the OSVR ClientKit library, so tests and benchmarks run
+// without a server
+//
+// OSVRFakeClientKit.cpp implements the ClientKit C functions the tracker and the header-only
+// ClientKit C++ wrappers call; link it instead of osvrClientKit, osvrUtil stays. every
+// interface reports the pose its source returns on each osvrClientUpdate, stamped with the
+// time set here. the display is one viewer at /me/head with two eyes 64 mm apart, each on
+// half of one 1920x1080 display input. single-threaded: one poll thread drives it.
+
+namespace OSVRFakeClientKit
+{
+	// pose of interface `index`, counted in the order interfaces were first requested,
+	// at time `now`. false while it has no state
+	typedef bool (*PoseSource)(uint32_t index, const OSVR_TimeValue& now, OSVR_PoseState& pose);
+
+	// identity for every interface when not set
+	void setPoseSource(PoseSource source);
+
+	// report time of the next osvrClientUpdate
+	void setTime(const OSVR_TimeValue& now);
+
+	// interfaces requested so far and their client handles, e.g. for OSVRPoseTable::insert
+	uint32_t getInterfaceCount();
+	OSVR_ClientInterface getInterface(uint32_t index);
+
+	// reports of every interface for the current time without a context update, what a
+	// server tick does
+	void report();
+
+	// forgets every interface and the pose source
+	void reset();
+}
@@ -0,0 +1,94 @@
+// throughput of the UDP pose packets: encoding on the publisher and decoding on the
+// receiver, for keyframes and deltas at several interface counts, without sockets
+//
+//   g++ -std=c++14 -O2 -I../src OSVRNetworkBenchmark.cpp ../src/OSVRNetwork.cpp ../src/OSVRLog.cpp -lpthread -o OSVRNetworkBenchmark
+
+#include <vector>
+#include <string>
+#include <cstdio>
+
+#include "OSVRNetwork.h"
+#include "OSVRTest.h"
+
+int main()
+{
+	const double precision = 0.0001;
+	const size_t rounds = 2000;
+	const uint32_t counts[] = { 1, 16, 256, 1024 };
+
+	for (uint32_t count : counts)
+	{
+		OSVRTest::Random random(count);
+		std::vector<std::string> paths(count);
+		std::vector<OSVRPoseSample> samples(count);
+		for (uint32_t h = 0; h < count; h++)
+		{
+			paths[h] = "/me/tracker/" + std::to_string(h);
+			OSVRPoseSample& s = samples[h];
+			s.handle = h;
+			s.path = paths[h].c_str();
+			for (int k = 0; k < 3; k++)
+				s.translation[k] = random.uniform(-2, 2);
+			random.quaternion(s.rotation);
+			s.timestamp = 1000000 + h;
+			s.valid = true;
+		}
+
+		std::vector<uint8_t> keyframe(OSVRPosePacket::MAX_SIZE), delta(OSVRPosePacket::MAX_SIZE);
+		std::vector<int32_t> keyframe_positions;
+		size_t keyframe_size = 0, delta_size = 0;
+		char name[64];
+
+		std::snprintf(name, sizeof(name), "encode keyframe, %u interfaces", count);
+		OSVRTest::benchmark(name, rounds * count, [&]
+		{
+			for (size_t r = 0; r < rounds; r++)
+				keyframe_size = OSVRPosePacket::encode(keyframe.data(), keyframe.size(), 1, 1, samples.data(), count, precision, keyframe_positions);
+		});
+		// small moves against the keyframe, as between two ticks
+		for (auto& s : samples)
+			s.translation[0] += 0.001f;
+		std::snprintf(name, sizeof(name), "encode delta, %u interfaces", count);
+		OSVRTest::benchmark(name, rounds * count, [&]
+		{
+			for (size_t r = 0; r < rounds; r++)
+				delta_size = OSVRPosePacket::encode(delta.data(), delta.size(), 2, 1, samples.data(), count, precision, keyframe_positions);
+		});
+		OSVR_CHECK(keyframe_size > 0 && delta_size > 0);
+
+		// the packets are encoded once, the loop only rewrites the sequence numbers of the
+		// header: u16 magic, u8 version, u8 flags, u32 seq, u32 keyframe seq
+		auto putSeq = [](std::vector<uint8_t>& packet, size_t offset, uint32_t seq)
+		{
+			for (int i = 0; i < 4; i++)
+				packet[offset + i] = uint8_t(seq >> (8 * i));
+		};
+		bool accepted = true;
+		std::snprintf(name, sizeof(name), "receive, %u interfaces", count);
+		OSVRTest::benchmark(name, rounds * count, [&]
+		{
+			OSVRPoseReceiver receiver;
+			for (uint32_t h = 0; h < count; h++)
+				receiver.addInterface(paths[h]);
+			// a keyframe every 60 packets and deltas against it in between, as on the wire
+			uint32_t keyframe_seq = 0;
+			for (uint32_t seq = 1; seq <= rounds; seq++)
+			{
+				if (seq % 60 == 1)
+				{
+					keyframe_seq = seq;
+					putSeq(keyframe, 4, seq);
+					putSeq(keyframe, 8, seq);
+					accepted = receiver.receive(keyframe.data(), keyframe_size) && accepted;
+					continue;
+				}
+				putSeq(delta, 4, seq);
+				putSeq(delta, 8, keyframe_seq);
+				accepted = receiver.receive(delta.data(), delta_size) && accepted;
+			}
+		});
+		OSVR_CHECK(accepted);
+		std::printf("%-40s %10zu bytes keyframe, %zu bytes delta\n", "", keyframe_size, delta_size);
+	}
+	return OSVRTest::result();
+}
@@ -0,0 +1,192 @@
+// OSVRPosePublisher/OSVRPoseReceiver over a lossy link and over the loopback interface
+//
+// the lossy link feeds the receiver the datagrams the publisher would send, with drops,
+// reordering, a duplicate and a truncated packet, and checks the statistics and every
+// decoded pose against what was sent
+//
+//   g++ -std=c++14 -O2 -I../src OSVRNetworkTest.cpp ../src/OSVRNetwork.cpp ../src/OSVRLog.cpp -lpthread -o OSVRNetworkTest
+
+#include <vector>
+#include <set>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include "OSVRNetwork.h"
+#include "OSVRTest.h"
+
+namespace
+{
+	const double PRECISION = 0.0001;
+	const int KEYFRAME_INTERVAL = 10;
+	const char* PATHS[] = { "/me/head", "/me/hands/left", "/me/hands/right" };
+	const uint32_t NUM_INTERFACES = 3;
+
+	struct Packet
+	{
+		uint32_t seq;
+		bool keyframe;
+		std::vector<OSVRPoseSample> samples;
+		std::vector<uint8_t> data;
+	};
+
+	// the poses of tick seq, different for every tick and interface
+	std::vector<OSVRPoseSample> makeSamples(uint32_t seq)
+	{
+		OSVRTest::Random random(seq);
+		std::vector<OSVRPoseSample> samples(NUM_INTERFACES);
+		for (uint32_t h = 0; h < NUM_INTERFACES; h++)
+		{
+			OSVRPoseSample& s = samples[h];
+			s.handle = h;
+			s.path = PATHS[h];
+			for (int k = 0; k < 3; k++)
+				s.translation[k] = random.uniform(-2, 2);
+			random.quaternion(s.rotation);
+			s.timestamp = int64_t(seq) * 1000 + h;
+			s.valid = true;
+		}
+		return samples;
+	}
+
+	// the datagrams OSVRPosePublisher::send produces for ticks 1 - count
+	std::vector<Packet> makePackets(uint32_t count)
+	{
+		std::vector<Packet> packets;
+		std::vector<int32_t> keyframe_positions;
+		uint32_t keyframe_seq = 0;
+		for (uint32_t seq = 1; seq <= count; seq++)
+		{
+			if (seq - keyframe_seq >= uint32_t(KEYFRAME_INTERVAL) || keyframe_positions.empty())
+				keyframe_seq = seq;
+			Packet p;
+			p.seq = seq;
+			p.keyframe = keyframe_seq == seq;
+			p.samples = makeSamples(seq);
+			p.data.resize(OSVRPosePacket::MAX_SIZE);
+			size_t size = OSVRPosePacket::encode(p.data.data(), p.data.size(), seq, keyframe_seq, p.samples.data(), p.samples.size(), PRECISION, keyframe_positions);
+			OSVR_CHECK(size > 0);
+			p.data.resize(size);
+			packets.push_back(p);
+		}
+		return packets;
+	}
+
+	bool samePose(OSVRPoseReceiver& receiver, uint32_t handle, const OSVRPoseSample& sent)
+	{
+		OSVRVec3 t;
+		OSVRQuat q;
+		int64_t timestamp;
+		if (receiver.getInterfacePose(handle, t, q, timestamp) == false)
+			return false;
+		float position_error = std::fmax(std::fabs(t.x - sent.translation[0]), std::fmax(std::fabs(t.y - sent.translation[1]), std::fabs(t.z - sent.translation[2])));
+		// q and -q are the same rotation
+		float dot = q.x * sent.rotation[0] + q.y * sent.rotation[1] + q.z * sent.rotation[2] + q.w * sent.rotation[3];
+		return position_error <= PRECISION && std::fabs(dot) > 0.9999f && timestamp == sent.timestamp;
+	}
+
+	void testLossyLink()
+	{
+		std::vector<Packet> packets = makePackets(60);
+		OSVRPoseReceiver receiver;
+		// the right hand stays unknown to this receiver and must be ignored
+		uint32_t head = receiver.addInterface(PATHS[0]);
+		uint32_t left = receiver.addInterface(PATHS[1]);
+
+		// keyframes at 1, 11, 21 ... lose 5 and 6, the keyframe 11 and 59, deliver 26 before
+		// 25 and 30 twice
+		std::vector<uint32_t> order;
+		for (uint32_t seq = 1; seq <= 60; seq++)
+		{
+			if (seq == 5 || seq == 6 || seq == 11 || seq == 59 || seq == 25)
+				continue;
+			order.push_back(seq);
+			if (seq == 26)
+				order.push_back(25);
+			if (seq == 30)
+				order.push_back(30);
+		}
+
+		std::set<uint32_t> delivered;
+		uint32_t newest = 0;
+		uint32_t applied = 0; // last packet whose poses the receiver holds
+		for (uint32_t seq : order)
+		{
+			const Packet& p = packets[seq - 1];
+			bool duplicate = delivered.insert(seq).second == false;
+			bool stale = seq < newest || duplicate;
+			bool orphan = seq >= 12 && seq <= 20; // deltas against the lost keyframe 11
+			bool accepted = receiver.receive(p.data.data(), p.data.size());
+			OSVR_CHECK(accepted == (stale == false && orphan == false));
+			if (accepted)
+				applied = seq;
+			if (stale == false)
+				newest = seq;
+
+			// stale or orphaned packets leave the poses of the last applied packet in place
+			const Packet& expected = packets[applied - 1];
+			OSVR_CHECK(samePose(receiver, head, expected.samples[0]));
+			OSVR_CHECK(samePose(receiver, left, expected.samples[1]));
+		}
+		OSVR_CHECK(applied == 60);
+
+		// a cut-off datagram changes nothing
+		const Packet& last = packets.back();
+		OSVR_CHECK(receiver.receive(last.data.data(), 10) == false);
+
+		OSVRNetworkStats stats = receiver.getStats();
+		OSVR_CHECK(stats.packets == 57);
+		OSVR_CHECK(stats.lost == 5);       // 5, 6, 11, 25 when 26 came and 59
+		OSVR_CHECK(stats.reordered == 2);  // 25 after 26, the second 30
+		OSVR_CHECK(stats.no_keyframe == 9); // 12 - 20
+		OSVR_CHECK(stats.malformed == 1);
+		OSVR_CHECK(samePose(receiver, head, last.samples[0]));
+		OSVR_CHECK(samePose(receiver, left, last.samples[1]));
+	}
+
+	void testLoopback()
+	{
+		const uint16_t port = 47913;
+		OSVRPoseReceiver receiver;
+		OSVRPosePublisher publisher;
+		if (receiver.open(port, PRECISION) == false || publisher.open("127.0.0.1", port, KEYFRAME_INTERVAL, PRECISION) == false)
+		{
+			std::printf("no loopback socket, skipping the loopback test\n");
+			return;
+		}
+		uint32_t head = receiver.addInterface(PATHS[0]);
+
+		const uint32_t count = 200;
+		std::vector<OSVRPoseSample> samples;
+		for (uint32_t seq = 1; seq <= count; seq++)
+		{
+			samples = makeSamples(seq);
+			OSVR_CHECK(publisher.send(samples.data(), samples.size()));
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+		}
+
+		// the receiver thread catches up
+		bool arrived = false;
+		for (int i = 0; i < 200 && arrived == false; i++)
+		{
+			arrived = samePose(receiver, head, samples[0]);
+			if (arrived == false)
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		OSVR_CHECK(arrived);
+		OSVRNetworkStats stats = receiver.getStats();
+		OSVR_CHECK(stats.packets == count);
+		OSVR_CHECK(stats.lost == 0 && stats.reordered == 0 && stats.malformed == 0);
+		receiver.close();
+		publisher.close();
+	}
+}
+
+int main()
+{
+	testLossyLink();
+	testLoopback();
+	return OSVRTest::result();
+}
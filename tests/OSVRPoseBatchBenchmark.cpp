@@ -0,0 +1,61 @@
+// time per pose of every OSVRPoseBatch kernel the CPU supports, for one pose table shard
+// and for a full table
+//
+//   g++ -std=c++14 -O2 -I../src OSVRPoseBatchBenchmark.cpp ../src/OSVRPoseBatch.cpp -o OSVRPoseBatchBenchmark
+
+#include <vector>
+#include <cstdio>
+
+#include "OSVRPoseBatch.h"
+#include "OSVRTest.h"
+
+int main()
+{
+	using namespace OSVRPoseBatch;
+
+	const size_t counts[] = { 64, 4096 };
+	const size_t poses_per_run = 1 << 22;
+
+	for (size_t count : counts)
+	{
+		OSVRTest::Random random(count);
+		std::vector<double> data[7];
+		for (auto& d : data)
+			d.resize(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			float q[4];
+			random.quaternion(q);
+			for (int k = 0; k < 3; k++)
+				data[k][i] = random.uniform(-3, 3);
+			data[3][i] = q[3];
+			data[4][i] = q[0];
+			data[5][i] = q[1];
+			data[6][i] = q[2];
+		}
+		OSVRPoseColumns in = { { data[0].data(), data[1].data(), data[2].data() }, { data[3].data(), data[4].data(), data[5].data(), data[6].data() } };
+		std::vector<float> matrices(count * 16), positions(count * 3), rotations(count * 4);
+		size_t repeats = poses_per_run / count;
+
+		for (int i = ISA_SCALAR; i <= getBestIsa(); i++)
+		{
+			Isa isa = Isa(i);
+			char name[64];
+			std::snprintf(name, sizeof(name), "toMatrices %s, %zu poses", getIsaName(isa), count);
+			OSVRTest::benchmark(name, repeats * count, [&]
+			{
+				for (size_t r = 0; r < repeats; r++)
+					toMatrices(in, count, matrices.data(), isa);
+			});
+			std::snprintf(name, sizeof(name), "toPoses %s, %zu poses", getIsaName(isa), count);
+			OSVRTest::benchmark(name, repeats * count, [&]
+			{
+				for (size_t r = 0; r < repeats; r++)
+					toPoses(in, count, positions.data(), rotations.data(), isa);
+			});
+		}
+		// keeps the last results alive and checks the kernel wrote something sensible
+		OSVR_CHECK(matrices[15] == 1.0f && positions[0] == float(data[0][0]));
+	}
+	return OSVRTest::result();
+}
@@ -0,0 +1,156 @@
+// every kernel of OSVRPoseBatch against a double precision reference and against the scalar
+// kernel, on random poses and on counts that leave a tail for each vector width
+//
+//   g++ -std=c++14 -O2 -I../src OSVRPoseBatchTest.cpp ../src/OSVRPoseBatch.cpp -o OSVRPoseBatchTest
+
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+
+#include "OSVRPoseBatch.h"
+#include "OSVRTest.h"
+
+namespace
+{
+	const float GUARD = -12345.0f; // written past the output, must survive
+	const size_t GUARD_SIZE = 16;
+
+	// columns of `count` poses, starting one double into the allocation so no load is aligned
+	struct Columns
+	{
+		std::vector<double> data[7];
+		OSVRPoseColumns columns;
+
+		Columns(size_t count, OSVRTest::Random& random)
+		{
+			for (auto& d : data)
+				d.resize(count + 1);
+			for (size_t i = 0; i < count; i++)
+			{
+				float q[4];
+				random.quaternion(q);
+				// tracker output isn't always unit length, and a zero quaternion must not divide by zero
+				float scale = i % 5 == 3 ? random.uniform(0.5f, 2.0f) : 1.0f;
+				if (i % 17 == 9)
+					scale = 0.0f;
+				for (int k = 0; k < 3; k++)
+					data[k][i + 1] = random.uniform(-3, 3);
+				data[3][i + 1] = q[3] * scale; // w first, like OSVR_Quaternion
+				data[4][i + 1] = q[0] * scale;
+				data[5][i + 1] = q[1] * scale;
+				data[6][i + 1] = q[2] * scale;
+			}
+			columns = { { &data[0][1], &data[1][1], &data[2][1] }, { &data[3][1], &data[4][1], &data[5][1], &data[6][1] } };
+		}
+	};
+
+	// what ofMatrix4x4::setRotate + setTranslation build, in double
+	void referenceMatrix(const OSVRPoseColumns& in, size_t i, double m[16])
+	{
+		double w = in.rotation[0][i], x = in.rotation[1][i], y = in.rotation[2][i], z = in.rotation[3][i];
+		double length2 = x * x + y * y + z * z + w * w;
+		double s = length2 > 0 ? 2 / length2 : 0;
+		double xx = x * x * s, xy = x * y * s, xz = x * z * s, yy = y * y * s, yz = y * z * s, zz = z * z * s;
+		double wx = w * x * s, wy = w * y * s, wz = w * z * s;
+		double r[16] = {
+			1 - (yy + zz), xy + wz, xz - wy, 0,
+			xy - wz, 1 - (xx + zz), yz + wx, 0,
+			xz + wy, yz - wx, 1 - (xx + yy), 0,
+			in.translation[0][i], in.translation[1][i], in.translation[2][i], 1
+		};
+		std::memcpy(m, r, sizeof(r));
+	}
+
+	std::vector<float> guarded(size_t size)
+	{
+		return std::vector<float>(size + GUARD_SIZE, GUARD);
+	}
+
+	bool guardIntact(const std::vector<float>& out, size_t size)
+	{
+		for (size_t i = size; i < out.size(); i++)
+		{
+			if (out[i] != GUARD)
+				return false;
+		}
+		return true;
+	}
+
+	float maxDifference(const std::vector<float>& a, const std::vector<float>& b, size_t size)
+	{
+		float difference = 0;
+		for (size_t i = 0; i < size; i++)
+			difference = std::fmax(difference, std::fabs(a[i] - b[i]));
+		return difference;
+	}
+
+	void testIsa(OSVRPoseBatch::Isa isa, size_t count, OSVRTest::Random& random)
+	{
+		Columns c(count, random);
+		const OSVRPoseColumns& in = c.columns;
+
+		std::vector<float> matrices = guarded(count * 16), scalar_matrices = guarded(count * 16);
+		OSVRPoseBatch::toMatrices(in, count, matrices.data(), isa);
+		OSVRPoseBatch::toMatrices(in, count, scalar_matrices.data(), OSVRPoseBatch::ISA_SCALAR);
+		OSVR_CHECK(guardIntact(matrices, count * 16));
+
+		// float rounding of the inputs and of a dozen operations on values up to 3 m
+		double reference_error = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			double m[16];
+			referenceMatrix(in, i, m);
+			for (int k = 0; k < 16; k++)
+				reference_error = std::fmax(reference_error, std::fabs(m[k] - matrices[i * 16 + k]));
+		}
+		OSVR_CHECK(reference_error < 1e-5);
+		// the kernels promise the scalar operations in the scalar order
+		OSVR_CHECK(maxDifference(matrices, scalar_matrices, count * 16) == 0.0f);
+
+		std::vector<float> positions = guarded(count * 3), rotations = guarded(count * 4);
+		std::vector<float> scalar_positions = guarded(count * 3), scalar_rotations = guarded(count * 4);
+		OSVRPoseBatch::toPoses(in, count, positions.data(), rotations.data(), isa);
+		OSVRPoseBatch::toPoses(in, count, scalar_positions.data(), scalar_rotations.data(), OSVRPoseBatch::ISA_SCALAR);
+		OSVR_CHECK(guardIntact(positions, count * 3));
+		OSVR_CHECK(guardIntact(rotations, count * 4));
+		OSVR_CHECK(maxDifference(positions, scalar_positions, count * 3) == 0.0f);
+		OSVR_CHECK(maxDifference(rotations, scalar_rotations, count * 4) == 0.0f);
+		for (size_t i = 0; i < count; i++)
+		{
+			OSVR_CHECK(positions[i * 3] == float(in.translation[0][i]));
+			OSVR_CHECK(rotations[i * 4 + 3] == float(in.rotation[0][i]));
+			OSVR_CHECK(rotations[i * 4] == float(in.rotation[1][i]));
+		}
+
+		// either output may be left out
+		std::vector<float> only_positions = guarded(count * 3), only_rotations = guarded(count * 4);
+		OSVRPoseBatch::toPoses(in, count, only_positions.data(), nullptr, isa);
+		OSVRPoseBatch::toPoses(in, count, nullptr, only_rotations.data(), isa);
+		OSVR_CHECK(maxDifference(only_positions, positions, count * 3 + GUARD_SIZE) == 0.0f);
+		OSVR_CHECK(maxDifference(only_rotations, rotations, count * 4 + GUARD_SIZE) == 0.0f);
+	}
+}
+
+int main()
+{
+	using namespace OSVRPoseBatch;
+
+	// empty, below, at and around the SSE2 and AVX2 widths, a shard and odd sizes
+	const size_t counts[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 11, 15, 16, 17, 31, 33, 63, 64, 65, 100, 1023 };
+
+	for (int i = ISA_SCALAR; i <= ISA_AVX2; i++)
+	{
+		Isa isa = Isa(i);
+		if (isa > getBestIsa())
+		{
+			std::printf("%s: not supported by this CPU, skipped\n", getIsaName(isa));
+			continue;
+		}
+		OSVRTest::Random random(i + 1);
+		for (size_t count : counts)
+			testIsa(isa, count, random);
+		std::printf("%s: tested\n", getIsaName(isa));
+	}
+	return OSVRTest::result();
+}
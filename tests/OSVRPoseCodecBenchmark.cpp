@@ -0,0 +1,87 @@
+// encode and decode throughput of OSVRPoseEncoder/OSVRPoseDecoder on smooth tracking data,
+// plus the coded size per sample and a round-trip check
+//
+//   g++ -std=c++14 -O2 -I../src OSVRPoseCodecBenchmark.cpp ../src/OSVRPoseCodec.cpp -o OSVRPoseCodecBenchmark
+
+#include <vector>
+#include <cmath>
+#include <cstdio>
+
+#include "OSVRPoseCodec.h"
+#include "OSVRTest.h"
+
+int main()
+{
+	const uint32_t interfaces = 16;
+	const size_t count = 200000;
+
+	// interfaces reporting round robin at 1 kHz, moving slowly like tracked devices do
+	std::vector<OSVRPoseSample> samples(count);
+	OSVRTest::Random random;
+	std::vector<float> phase(interfaces);
+	for (uint32_t i = 0; i < interfaces; i++)
+		phase[i] = random.uniform(0, 6.2831853f);
+	for (size_t n = 0; n < count; n++)
+	{
+		OSVRPoseSample& s = samples[n];
+		uint32_t i = uint32_t(n % interfaces);
+		float t = float(n / interfaces) * 0.001f + phase[i];
+		s.handle = i;
+		s.path = nullptr;
+		s.translation[0] = 0.5f * std::sin(t);
+		s.translation[1] = 1.6f + 0.05f * std::sin(3 * t);
+		s.translation[2] = 0.5f * std::cos(t);
+		float half = 0.5f * std::sin(0.7f * t);
+		s.rotation[0] = 0;
+		s.rotation[1] = std::sin(half);
+		s.rotation[2] = 0;
+		s.rotation[3] = std::cos(half);
+		s.timestamp = int64_t(n / interfaces) * 1000 + i;
+		s.valid = true;
+	}
+
+	std::vector<uint8_t> buffer(count * OSVRPoseEncoder::MAX_SAMPLE_SIZE);
+	size_t bytes = 0;
+	OSVRTest::benchmark("encode", count, [&]
+	{
+		OSVRPoseEncoder encoder(0.001);
+		bytes = 0;
+		for (const OSVRPoseSample& s : samples)
+			bytes += encoder.encode(s, &buffer[bytes]);
+	});
+
+	std::vector<OSVRPoseSample> decoded(count);
+	size_t decoded_count = 0;
+	OSVRTest::benchmark("decode", count, [&]
+	{
+		OSVRPoseDecoder decoder(0.001);
+		size_t offset = 0;
+		decoded_count = 0;
+		while (offset < bytes)
+		{
+			size_t used = decoder.decode(&buffer[offset], bytes - offset, decoded[decoded_count]);
+			if (used == 0)
+				break;
+			offset += used;
+			decoded_count++;
+		}
+	});
+	std::printf("%-40s %10.2f bytes/sample\n", "coded size", double(bytes) / double(count));
+
+	OSVR_CHECK(decoded_count == count);
+	float max_position = 0, max_rotation = 0;
+	for (size_t n = 0; n < decoded_count && n < count; n++)
+	{
+		OSVR_CHECK(decoded[n].handle == samples[n].handle);
+		OSVR_CHECK(decoded[n].timestamp == samples[n].timestamp);
+		for (int k = 0; k < 3; k++)
+			max_position = std::fmax(max_position, std::fabs(decoded[n].translation[k] - samples[n].translation[k]));
+		for (int k = 0; k < 4; k++)
+			max_rotation = std::fmax(max_rotation, std::fabs(decoded[n].rotation[k] - samples[n].rotation[k]));
+	}
+	// half a quantum of position, smallest-three keeps rotations to a few 1e-5
+	OSVR_CHECK(max_position <= 0.0005f + 1e-6f);
+	OSVR_CHECK(max_rotation < 1e-3f);
+	std::printf("max error: position %g m, rotation %g\n", max_position, max_rotation);
+	return OSVRTest::result();
+}
@@ -0,0 +1,160 @@
+// OSVRPoseTable from 1 to 1000 interfaces: a poll with every report fresh, a poll with none,
+// reading every interface, and polling while reader threads read all the time
+//
+//   g++ -std=c++14 -O2 -I../src -I<OSVR include> OSVRPoseTableBenchmark.cpp OSVRFakeClientKit.cpp ../src/OSVRPoseTable.cpp -lpthread -o OSVRPoseTableBenchmark
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "OSVRPoseTable.h"
+#include "OSVRFakeClientKit.h"
+#include "OSVRTest.h"
+
+// ignore conflict define
+#pragma push_macro("ignore")
+#undef near
+#undef far
+#include "osvr/ClientKit/ContextC.h"
+#include "osvr/ClientKit/InterfaceC.h"
+#pragma pop_macro("ignore")
+
+namespace
+{
+	bool movingPose(uint32_t index, const OSVR_TimeValue& now, OSVR_PoseState& pose)
+	{
+		double t = double(now.seconds) + now.microseconds * 1e-6 + index;
+		pose.translation.data[0] = std::sin(t);
+		pose.translation.data[1] = 1.6;
+		pose.translation.data[2] = std::cos(t);
+		pose.rotation.data[0] = std::cos(t * 0.5);
+		pose.rotation.data[1] = 0;
+		pose.rotation.data[2] = std::sin(t * 0.5);
+		pose.rotation.data[3] = 0;
+		return true;
+	}
+
+	OSVR_TimeValue tickTime(uint64_t tick)
+	{
+		return OSVR_TimeValue{ OSVR_TimeValue_Seconds(1 + tick / 1000), OSVR_TimeValue_Microseconds(tick % 1000 * 1000) };
+	}
+}
+
+int main()
+{
+	const uint32_t counts[] = { 1, 10, 100, 1000 };
+	const size_t polls_per_run = 200000;
+
+	OSVR_ClientContext ctx = osvrClientInit("com.osvr.benchmark", 0);
+	OSVRFakeClientKit::setPoseSource(movingPose);
+
+	for (uint32_t count : counts)
+	{
+		OSVRPoseTable table;
+		for (uint32_t h = 0; h < count; h++)
+		{
+			char path[32];
+			std::snprintf(path, sizeof(path), "/me/tracker/%u", h);
+			OSVR_ClientInterface iface;
+			osvrClientGetInterface(ctx, path, &iface);
+			table.insert(h, iface);
+		}
+
+		size_t polls = std::max<size_t>(10, polls_per_run / count);
+		uint64_t tick = 0;
+		OSVR_TimeValue newest;
+		std::vector<uint32_t> lost;
+		lost.reserve(count);
+		bool fresh = true;
+		char name[64];
+
+		// a new report on every interface before each poll, what a busy server tick looks like.
+		// generating the reports is measured separately and taken out
+		double report_ns = OSVRTest::benchmark("  (fake reports)", polls * count, [&]
+		{
+			for (size_t p = 0; p < polls; p++)
+			{
+				OSVRFakeClientKit::setTime(tickTime(++tick));
+				OSVRFakeClientKit::report();
+			}
+		});
+		std::snprintf(name, sizeof(name), "poll all fresh, %u interfaces", count);
+		double fresh_ns = OSVRTest::benchmark(name, polls * count, [&]
+		{
+			for (size_t p = 0; p < polls; p++)
+			{
+				OSVRFakeClientKit::setTime(tickTime(++tick));
+				OSVRFakeClientKit::report();
+				fresh = table.poll(newest, lost) && fresh;
+			}
+		});
+		std::printf("%-40s %10.2f ns/item, %.0f ns per poll\n", "  without the reports", fresh_ns - report_ns, (fresh_ns - report_ns) * count);
+		OSVR_CHECK(fresh);
+
+		std::snprintf(name, sizeof(name), "poll nothing fresh, %u interfaces", count);
+		OSVRTest::benchmark(name, polls * count, [&]
+		{
+			for (size_t p = 0; p < polls; p++)
+				table.poll(newest, lost);
+		});
+
+		OSVR_PoseState state;
+		OSVR_TimeValue timestamp;
+		bool read = true;
+		std::snprintf(name, sizeof(name), "read, %u interfaces", count);
+		OSVRTest::benchmark(name, polls * count, [&]
+		{
+			for (size_t p = 0; p < polls; p++)
+			{
+				for (uint32_t h = 0; h < count; h++)
+					read = table.read(h, state, timestamp) && read;
+			}
+		});
+		OSVR_CHECK(read);
+
+		// readers retry while the shard they read is being written
+		std::atomic<bool> running{ true };
+		std::atomic<uint64_t> reads{ 0 };
+		std::vector<std::thread> readers;
+		for (int r = 0; r < 2; r++)
+		{
+			readers.emplace_back([&, r]
+			{
+				OSVR_PoseState s;
+				OSVR_TimeValue t;
+				uint64_t n = 0;
+				uint32_t h = r;
+				while (running.load(std::memory_order_relaxed))
+				{
+					table.read(h, s, t);
+					h = h + 1 < count ? h + 1 : 0;
+					n++;
+				}
+				reads += n;
+			});
+		}
+		std::snprintf(name, sizeof(name), "poll all fresh, 2 readers, %u", count);
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		double contended_ns = OSVRTest::benchmark(name, polls * count, [&]
+		{
+			for (size_t p = 0; p < polls; p++)
+			{
+				OSVRFakeClientKit::setTime(tickTime(++tick));
+				OSVRFakeClientKit::report();
+				table.poll(newest, lost);
+			}
+		});
+		running = false;
+		for (auto& t : readers)
+			t.join();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		std::printf("%-40s %10.2f ns/item, readers %.1f M reads/s\n", "  without the reports", contended_ns - report_ns, reads / seconds * 1e-6);
+	}
+
+	osvrClientShutdown(ctx);
+	return OSVRTest::result();
+}
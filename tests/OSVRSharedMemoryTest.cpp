@@ -0,0 +1,196 @@
+// OSVRSharedMemoryWriter to OSVRSharedMemoryReader through a real segment: poses, paths up to
+// and past MAX_PATH_LENGTH, a read the writer tears and one it keeps busy, a segment of
+// another version, a closed writer, and a reader racing a writer thread
+//
+//   g++ -std=c++14 -O2 -I../src OSVRSharedMemoryTest.cpp ../src/OSVRSharedMemory.cpp -lpthread -lrt -o OSVRSharedMemoryTest
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+
+#include "OSVRSharedMemory.h"
+#include "OSVRTest.h"
+
+namespace
+{
+	const char* SEGMENT = "osvr_shared_memory_test";
+
+	// what the tracking core writes for interface i of a frame, every field derived from value
+	void writeInterface(OSVRSharedFrame& f, uint32_t i, const std::string& path, float value)
+	{
+		auto& face = f.interfaces[i];
+		OSVRSharedFrame::setPath(face, path);
+		for (int k = 0; k < 3; k++)
+			face.translation[k] = value + k;
+		for (int k = 0; k < 4; k++)
+			face.rotation[k] = value;
+		face.timestamp = int64_t(value);
+		face.valid = 1;
+	}
+
+	void testRoundTrip(OSVRSharedMemoryWriter& writer, OSVRSharedMemoryReader& reader)
+	{
+		const std::string base = "/me/tracker/";
+		const std::string exact(OSVRSharedFrame::MAX_PATH_LENGTH - 1, 'a'); // fits with its terminator
+		const std::string at_limit(OSVRSharedFrame::MAX_PATH_LENGTH, 'a');
+		const std::string long_path = base + std::string(100, 'b') + "/left";
+		const std::string long_twin = base + std::string(100, 'b') + "/right"; // same stored prefix
+		const std::string paths[] = { "/me/head", exact, at_limit, long_path, long_twin };
+		const uint32_t count = sizeof(paths) / sizeof(paths[0]);
+
+		OSVRSharedFrame* f = writer.beginWrite();
+		f->tick = 42;
+		f->num_interfaces = count;
+		for (uint32_t i = 0; i < count; i++)
+			writeInterface(*f, i, paths[i], float(i * 10));
+		writer.endWrite();
+
+		OSVR_CHECK(reader.getTick() == 42);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			OSVR_CHECK(reader.findInterface(paths[i]) == i);
+			float t[3], r[4];
+			int64_t timestamp = 0;
+			OSVR_CHECK(reader.getInterfacePose(i, t, r, &timestamp));
+			OSVR_CHECK(t[0] == float(i * 10) && t[2] == float(i * 10 + 2) && r[3] == float(i * 10));
+			OSVR_CHECK(timestamp == int64_t(i * 10));
+		}
+		// prefixes and extensions of stored paths are other paths
+		OSVR_CHECK(reader.findInterface("/me/hea") == OSVRSharedMemoryReader::INVALID_INTERFACE);
+		OSVR_CHECK(reader.findInterface("/me/head/") == OSVRSharedMemoryReader::INVALID_INTERFACE);
+		OSVR_CHECK(reader.findInterface(long_path.substr(0, OSVRSharedFrame::MAX_PATH_LENGTH - 1)) == OSVRSharedMemoryReader::INVALID_INTERFACE);
+		OSVR_CHECK(reader.findInterface(long_path + "x") == OSVRSharedMemoryReader::INVALID_INTERFACE);
+		// handles past the frame
+		float t[3], r[4];
+		OSVR_CHECK(reader.getInterfacePose(count, t, r) == false);
+		OSVR_CHECK(reader.getInterfacePose(OSVRSharedFrame::MAX_INTERFACES, t, r) == false);
+	}
+
+	void testTornRead(OSVRSharedMemoryWriter& writer, OSVRSharedMemoryReader& reader)
+	{
+		// the writer starts a frame while the reader copies, the copy is thrown away and redone
+		int calls = 0;
+		bool consistent = reader.read([&](const OSVRSharedFrame&)
+		{
+			if (calls++ == 0)
+			{
+				writer.beginWrite()->tick = 43;
+				writer.endWrite();
+			}
+		});
+		OSVR_CHECK(consistent);
+		OSVR_CHECK(calls == 2);
+		OSVR_CHECK(reader.getTick() == 43);
+
+		// a frame in progress for every attempt
+		writer.beginWrite();
+		calls = 0;
+		OSVR_CHECK(reader.read([&](const OSVRSharedFrame&) { calls++; }, 10) == false);
+		OSVR_CHECK(calls == 0);
+		writer.endWrite();
+		OSVR_CHECK(reader.read([&](const OSVRSharedFrame&) { calls++; }));
+		OSVR_CHECK(calls == 1);
+	}
+
+	void testVersion(OSVRSharedMemoryWriter& writer)
+	{
+		OSVRSharedMemoryReader reader;
+		writer.beginWrite()->version = OSVRSharedFrame::VERSION + 1;
+		writer.endWrite();
+		OSVR_CHECK(reader.open(SEGMENT) == false);
+		OSVR_CHECK(reader.isOpen() == false);
+
+		writer.beginWrite()->version = OSVRSharedFrame::VERSION;
+		writer.endWrite();
+		OSVR_CHECK(reader.open(SEGMENT));
+	}
+
+	// every field of a frame carries its tick, a torn copy mixes two
+	void testConcurrent(OSVRSharedMemoryWriter& writer, OSVRSharedMemoryReader& reader)
+	{
+		const uint32_t count = 64;
+		auto writeFrame = [&](uint64_t tick)
+		{
+			OSVRSharedFrame* f = writer.beginWrite();
+			f->tick = tick;
+			f->num_interfaces = count;
+			for (uint32_t i = 0; i < count; i++)
+				writeInterface(*f, i, "/me/tracker", float(tick % 1000000));
+			writer.endWrite();
+		};
+		writeFrame(1);
+
+		std::atomic<bool> running{ true };
+		std::atomic<uint64_t> written{ 1 };
+		std::thread thread([&]
+		{
+			for (uint64_t tick = 2; running.load(std::memory_order_relaxed); tick++)
+			{
+				writeFrame(tick);
+				written.store(tick, std::memory_order_relaxed);
+			}
+		});
+
+		uint64_t reads = 0, calls = 0, torn = 0, last_tick = 0;
+		bool ordered = true;
+		while (reads < 100000 || written.load(std::memory_order_relaxed) < 100000)
+		{
+			uint64_t tick = 0;
+			bool mixed = false;
+			bool consistent = reader.read([&](const OSVRSharedFrame& f)
+			{
+				calls++;
+				tick = f.tick;
+				float value = float(tick % 1000000);
+				mixed = false;
+				for (uint32_t k = 0; k < count; k++)
+					mixed = mixed || f.interfaces[k].translation[0] != value || f.interfaces[k].rotation[3] != value;
+			});
+			if (consistent == false)
+				continue;
+			reads++;
+			torn += mixed ? 1 : 0;
+			ordered = ordered && tick >= last_tick;
+			last_tick = tick;
+		}
+		running = false;
+		thread.join();
+
+		std::printf("%llu consistent reads, %llu retried copies, %llu frames written\n",
+			(unsigned long long)reads, (unsigned long long)(calls - reads), (unsigned long long)written.load());
+		OSVR_CHECK(reads > 0);
+		OSVR_CHECK(torn == 0);
+		OSVR_CHECK(ordered);
+	}
+}
+
+int main()
+{
+	OSVRSharedMemoryReader reader;
+	OSVR_CHECK(reader.open(SEGMENT) == false);
+
+	OSVRSharedMemoryWriter writer;
+	if (writer.open(SEGMENT) == false)
+	{
+		std::printf("shared memory not available, skipped\n");
+		return OSVRTest::result();
+	}
+	OSVR_CHECK(reader.open(SEGMENT));
+
+	testRoundTrip(writer, reader);
+	testTornRead(writer, reader);
+	testVersion(writer);
+	OSVR_CHECK(reader.open(SEGMENT));
+	testConcurrent(writer, reader);
+
+	// a closed writer fails every read instead of handing out stale poses
+	writer.close();
+	OSVR_CHECK(reader.getTick() == 0);
+	float t[3], r[4];
+	OSVR_CHECK(reader.getInterfacePose(0, t, r) == false);
+	reader.close();
+	OSVR_CHECK(reader.open(SEGMENT) == false);
+
+	return OSVRTest::result();
+}
@@ -0,0 +1,188 @@
+// OSVRSubscribers: ids, capacity and removal from inside a callback on one thread, then
+// threads adding and removing subscribers while another dispatches all the time. no
+// callback may run once remove() returned, and none may be running then
+//
+//   g++ -std=c++14 -O2 -I../src OSVRSubscribersTest.cpp -lpthread -o OSVRSubscribersTest
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+
+#include "OSVRSubscribers.h"
+#include "OSVRTest.h"
+
+namespace
+{
+	using Callback = OSVRDelegate<void(uint32_t)>;
+	using Subscribers = OSVRSubscribers<Callback, 16>;
+
+	void testSingleThread()
+	{
+		Subscribers subscribers;
+		int calls[3] = {};
+		int* c = calls;
+		OSVR_CHECK(subscribers.empty());
+
+		Subscribers::Id a = subscribers.add(1, [c](uint32_t) { c[0]++; });
+		Subscribers::Id any = subscribers.add(Subscribers::ANY_KEY, [c](uint32_t) { c[1]++; });
+		OSVR_CHECK(a != 0 && any != 0 && a != any);
+		subscribers.dispatch(1, 1u);
+		subscribers.dispatch(2, 2u);
+		OSVR_CHECK(calls[0] == 1 && calls[1] == 2);
+
+		// a removed id is dead for good, also once its slot was reused
+		subscribers.remove(a);
+		Subscribers::Id b = subscribers.add(1, [c](uint32_t) { c[2]++; });
+		OSVR_CHECK(b != a);
+		subscribers.remove(a);
+		subscribers.dispatch(1, 1u);
+		OSVR_CHECK(calls[0] == 1 && calls[2] == 1);
+		subscribers.remove(0);
+		subscribers.remove(0xff);
+
+		// every slot taken
+		std::vector<Subscribers::Id> ids;
+		for (;;)
+		{
+			Subscribers::Id id = subscribers.add(3, [](uint32_t) {});
+			if (id == 0)
+				break;
+			ids.push_back(id);
+		}
+		OSVR_CHECK(ids.size() == 16 - 2);
+		for (Subscribers::Id id : ids)
+			subscribers.remove(id);
+		subscribers.remove(b);
+		subscribers.remove(any);
+		OSVR_CHECK(subscribers.empty());
+	}
+
+	struct SelfRemoving
+	{
+		Subscribers* subscribers;
+		Subscribers::Id id;
+		int calls;
+	};
+
+	void testRemoveInsideCallback()
+	{
+		Subscribers subscribers;
+		SelfRemoving self = { &subscribers, 0, 0 };
+		SelfRemoving* s = &self;
+		self.id = subscribers.add(Subscribers::ANY_KEY, [s](uint32_t)
+		{
+			s->calls++;
+			s->subscribers->remove(s->id);
+		});
+
+		// the slot stays reserved until the bracket ends, the subscriber is not called again
+		subscribers.beginDispatch();
+		subscribers.dispatch(1, 1u);
+		subscribers.dispatch(2, 2u);
+		subscribers.endDispatch();
+		OSVR_CHECK(self.calls == 1);
+		subscribers.dispatch(1, 1u);
+		OSVR_CHECK(self.calls == 1);
+		OSVR_CHECK(subscribers.empty());
+	}
+
+	// one subscription of the stress test, never reused
+	struct Target
+	{
+		std::atomic<int> running{ 0 };
+		std::atomic<bool> removed{ false };
+	};
+
+	std::atomic<uint64_t> late_calls{ 0 };
+	std::atomic<uint64_t> total_calls{ 0 };
+
+	void callTarget(Target* t)
+	{
+		t->running.fetch_add(1);
+		if (t->removed.load())
+			late_calls++;
+		// now and then let a remove() run while the callback is in flight, also on one core
+		if (total_calls.fetch_add(1, std::memory_order_relaxed) % 16 == 0)
+			std::this_thread::yield();
+		t->running.fetch_sub(1);
+	}
+
+	void testConcurrent()
+	{
+		const int threads = 3;
+		const int per_thread = 20000;
+
+		Subscribers subscribers;
+		std::vector<Target> targets(threads * per_thread);
+		std::atomic<bool> dispatching{ true };
+		std::atomic<uint64_t> still_running{ 0 };
+		std::atomic<uint64_t> full{ 0 };
+
+		std::thread dispatcher([&]
+		{
+			uint32_t key = 0;
+			while (dispatching.load(std::memory_order_relaxed))
+			{
+				// a tick: several keys bracketed as one, like the poll thread publishing a shard
+				subscribers.beginDispatch();
+				for (int k = 0; k < 4; k++)
+					subscribers.dispatch(key++ % 8, 0u);
+				subscribers.endDispatch();
+				// between ticks, so the test also progresses on a single core
+				if (key % 64 == 0)
+					std::this_thread::yield();
+			}
+		});
+
+		std::vector<std::thread> subscribing;
+		for (int t = 0; t < threads; t++)
+		{
+			subscribing.emplace_back([&, t]
+			{
+				for (int n = 0; n < per_thread; n++)
+				{
+					Target* target = &targets[t * per_thread + n];
+					uint32_t key = n % 3 == 0 ? Subscribers::ANY_KEY : uint32_t(n % 8);
+					Subscribers::Id id = subscribers.add(key, [target](uint32_t) { callTarget(target); });
+					if (id == 0)
+					{
+						full++;
+						continue;
+					}
+					// give the dispatcher a chance to pick it up
+					for (int spin = n % 4; spin > 0; spin--)
+						std::this_thread::yield();
+					subscribers.remove(id);
+					if (target->running.load() != 0)
+						still_running++;
+					target->removed.store(true);
+				}
+			});
+		}
+		for (auto& t : subscribing)
+			t.join();
+		// dispatch a while longer, a subscriber that survived its remove would be called now
+		for (int i = 0; i < 1000; i++)
+			std::this_thread::yield();
+		dispatching = false;
+		dispatcher.join();
+
+		std::printf("%d subscriptions, %llu callbacks, %llu late, %llu running after remove, %llu adds on a full table\n",
+			threads * per_thread, (unsigned long long)total_calls.load(), (unsigned long long)late_calls.load(),
+			(unsigned long long)still_running.load(), (unsigned long long)full.load());
+		OSVR_CHECK(total_calls > 0);
+		OSVR_CHECK(late_calls == 0);
+		OSVR_CHECK(still_running == 0);
+		OSVR_CHECK(full == 0);
+		OSVR_CHECK(subscribers.empty());
+	}
+}
+
+int main()
+{
+	testSingleThread();
+	testRemoveInsideCallback();
+	testConcurrent();
+	return OSVRTest::result();
+}
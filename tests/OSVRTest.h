@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+
+// minimal checks and timing for the executables in tests/, no framework needed
+//
+// a test counts failed OSVR_CHECKs and returns OSVRTest::result() from main, so 0 means
+// passed. a benchmark times a callable over a number of items and prints ns per item.
+
+namespace OSVRTest
+{
+	inline int& failures() { static int count = 0; return count; }
+
+	inline void fail(const char* file, int line, const char* what)
+	{
+		std::printf("FAILED %s:%d: %s\n", file, line, what);
+		failures()++;
+	}
+
+	inline int result()
+	{
+		if (failures() == 0)
+			std::printf("passed\n");
+		else
+			std::printf("%d checks failed\n", failures());
+		return failures() == 0 ? 0 : 1;
+	}
+
+	// deterministic across platforms, unlike std::rand
+	struct Random
+	{
+		uint64_t state;
+		explicit Random(uint64_t seed = 1) :state(seed * 0x9e3779b97f4a7c15ull + 1) {}
+
+		uint32_t next()
+		{
+			state = state * 6364136223846793005ull + 1442695040888963407ull;
+			return uint32_t(state >> 33);
+		}
+
+		// uniform in [lo, hi)
+		float uniform(float lo, float hi) { return lo + (hi - lo) * float(next() >> 8) * (1.0f / 16777216.0f); }
+
+		// uniformly distributed unit quaternion, x y z w
+		void quaternion(float* q)
+		{
+			float u1 = uniform(0, 1), u2 = uniform(0, 6.2831853f), u3 = uniform(0, 6.2831853f);
+			float a = std::sqrt(1 - u1), b = std::sqrt(u1);
+			q[0] = a * std::sin(u2);
+			q[1] = a * std::cos(u2);
+			q[2] = b * std::sin(u3);
+			q[3] = b * std::cos(u3);
+		}
+	};
+
+	// best of a few runs of fn, which handles `items` items per call. prints and returns ns per item
+	template <class Fn>
+	double benchmark(const char* name, size_t items, Fn fn, int runs = 5)
+	{
+		typedef std::chrono::steady_clock Clock;
+		double best = 1e300;
+		for (int r = 0; r < runs; r++)
+		{
+			Clock::time_point begin = Clock::now();
+			fn();
+			double ns = std::chrono::duration<double, std::nano>(Clock::now() - begin).count() / double(items);
+			if (ns < best)
+				best = ns;
+		}
+		std::printf("%-40s %10.2f ns/item\n", name, best);
+		return best;
+	}
+}
+
+#define OSVR_CHECK(cond) do { if (!(cond)) OSVRTest::fail(__FILE__, __LINE__, #cond); } while (0)
@@ -0,0 +1,77 @@
+// command-line front end of OSVRSessionAnalyzer, prints the JSON summary of a session
+//
+//   g++ -std=c++14 -O2 -I../src OSVRAnalyze.cpp ../src/OSVRSessionAnalyzer.cpp ../src/OSVRSession.cpp
+//       ../src/OSVRPoseCodec.cpp ../src/OSVRLog.cpp -lpthread -o OSVRAnalyze
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "OSVRSessionAnalyzer.h"
+#include "OSVRLog.h"
+
+static void usage()
+{
+	std::fprintf(stderr,
+		"usage: OSVRAnalyze <session> [options]\n"
+		"  --dropout-ms <ms>      report gaps longer than this (50)\n"
+		"  --jump-meters <m>      position teleport threshold (0.1)\n"
+		"  --jump-degrees <deg>   rotation teleport threshold (45)\n"
+		"  --norm-tolerance <e>   allowed quaternion norm error (0.001)\n"
+		"  --max-events <n>       events listed per kind and interface (100)\n"
+		"  --threads <n>          worker threads, 0 for all (0)\n"
+		"  --output <file>        write the summary here instead of stdout\n");
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		usage();
+		return 2;
+	}
+
+	OSVRAnalyzerOptions options;
+	const char* output = nullptr;
+	for (int i = 2; i < argc; i++)
+	{
+		if (i + 1 >= argc)
+		{
+			usage();
+			return 2;
+		}
+		const char* name = argv[i];
+		const char* value = argv[++i];
+		if (std::strcmp(name, "--dropout-ms") == 0) options.dropout_ms = std::atof(value);
+		else if (std::strcmp(name, "--jump-meters") == 0) options.jump_meters = std::atof(value);
+		else if (std::strcmp(name, "--jump-degrees") == 0) options.jump_degrees = std::atof(value);
+		else if (std::strcmp(name, "--norm-tolerance") == 0) options.norm_tolerance = std::atof(value);
+		else if (std::strcmp(name, "--max-events") == 0) options.max_events = size_t(std::atol(value));
+		else if (std::strcmp(name, "--threads") == 0) options.threads = unsigned(std::atoi(value));
+		else if (std::strcmp(name, "--output") == 0) output = value;
+		else
+		{
+			usage();
+			return 2;
+		}
+	}
+
+	OSVRLog::setLevel(OSVR_LOG_WARNING);
+	OSVRSessionReader reader;
+	if (!reader.open(argv[1]))
+		return 1;
+
+	OSVRSessionAnalyzer analyzer(options);
+	bool complete = analyzer.analyze(reader);
+
+	if (output)
+	{
+		std::ofstream file(output);
+		analyzer.writeJson(file);
+	}
+	else
+		analyzer.writeJson(std::cout);
+	return complete ? 0 : 3;
+}